@@ -0,0 +1,11 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#ifndef SPACE_INVADERS_ACTION_H
+#define SPACE_INVADERS_ACTION_H
+
+enum Action {
+    ACTION_NONE, ACTION_LEFT, ACTION_RIGHT, ACTION_FIRE, ACTION_QUIT
+};
+#endif //SPACE_INVADERS_ACTION_H
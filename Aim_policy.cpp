@@ -0,0 +1,57 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#include "Aim_policy.h"
+
+static const int danger_rows = 4; // how far above its ship the bot looks for the bullets
+
+Action Aim_policy::act(const Observation &observation) {
+    int columns = observation.getColumns();
+    int rows = observation.getRows();
+
+    /// Find the player's ship, searching from the bottom
+    int player_left = -1, player_right = -1, player_row = -1;
+    for (int y = rows - 1; y >= 0 && player_row < 0; y--) {
+        for (int x = 0; x < columns; x++) {
+            if (observation.at(x, y) == Observation::PLAYER) {
+                if (player_left < 0) player_left = x;
+                player_right = x;
+                player_row = y;
+            }
+        }
+    }
+    if (player_row < 0) return ACTION_NONE;
+    int center = (player_left + player_right) / 2;
+
+    /// Dodge the bullets falling on the ship
+    for (int y = player_row - 1; y >= 0 && y >= player_row - danger_rows; y--) {
+        for (int x = player_left; x <= player_right; x++) {
+            if (observation.at(x, y) == Observation::ENEMY_BULLET) {
+                return x < center || player_left == 0 ? ACTION_RIGHT : ACTION_LEFT;
+            }
+        }
+    }
+
+    /// Go under the lowest enemy
+    int target = -1;
+    for (int y = player_row - 1; y >= 0 && target < 0; y--) {
+        for (int x = 0; x < columns; x++) {
+            Observation::Cell cell = observation.at(x, y);
+            if (cell == Observation::BIG_ENEMY || cell == Observation::SMALL_ENEMY) {
+                if (target < 0 || (x > center ? x - center : center - x) < (target > center ? target - center : center - target)) {
+                    target = x;
+                }
+            }
+        }
+    }
+    if (target < 0) return ACTION_NONE;
+    if (target < center) return ACTION_LEFT;
+    if (target > center) return ACTION_RIGHT;
+
+    /// Don't shoot own shields
+    for (int y = player_row - 1; y >= 0; y--) {
+        if (observation.at(center, y) == Observation::SHIELD) return ACTION_NONE;
+    }
+    return ACTION_FIRE;
+}
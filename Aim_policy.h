@@ -0,0 +1,21 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#ifndef SPACE_INVADERS_AIM_POLICY_H
+#define SPACE_INVADERS_AIM_POLICY_H
+
+#include "Policy.h"
+
+/**
+ * A simple bot for regression runs. It steps away from the enemy bullets falling
+ * on its ship, otherwise it goes under the lowest enemy and shoots when there is
+ * no own shield in the way.
+ */
+class Aim_policy : public Policy {
+public:
+    Action act(const Observation &observation);
+};
+
+
+#endif //SPACE_INVADERS_AIM_POLICY_H
@@ -5,14 +5,31 @@
 #include "BigBullet.h"
 
 BigBullet::BigBullet(short _pos_x, short _pos_y, int _min_x, int _max_x, int _min_y, int _max_y)
-        : Game_actor(_pos_x, _pos_y, 3, 3, _min_x, _max_x, _min_y, _max_y){
+        : Bullet(_pos_x, _pos_y, 3, 3, _min_x, _max_x, _min_y, _max_y){
+    damage = 5;
+    blast = 1;
+}
 
+void BigBullet::drawActor(const Viewport &view) {
+    int x = pos_x - view.getOrigin_x();
+    int y = pos_y - view.getOrigin_y();
+    mvprintw(y, x+1, "#");
+    mvprintw(y+1, x, "#");
+    mvprintw(y+1, x+1, "#");
+    mvprintw(y+1, x+2, "#");
+    mvprintw(y+2, x+1, "#");
 }
 
-void BigBullet::drawActor() {
-    mvprintw(pos_y, pos_x+1, "#");
-    mvprintw(pos_y+1, pos_x, "#");
-    mvprintw(pos_y+1, pos_x+1, "#");
-    mvprintw(pos_y+1, pos_x+2, "#");
-    mvprintw(pos_y+2, pos_x+1, "#");
+/**
+ * The same cross as the ASCII one, moving by dots instead of whole rows
+ */
+void BigBullet::drawDots(const Viewport &view, Braille_layer &layer, long tick, short color) {
+    int x = (pos_x - view.getOrigin_x()) * Braille_layer::DOT_COLUMNS;
+    int y = dotRowAt(tick, Braille_layer::DOT_ROWS) - view.getOrigin_y() * Braille_layer::DOT_ROWS;
+    for (int dot = 0; dot < Braille_layer::DOT_COLUMNS; dot++) {
+        layer.column(x + Braille_layer::DOT_COLUMNS + dot, y, height * Braille_layer::DOT_ROWS, color);
+    }
+    for (int dot = 0; dot < Braille_layer::DOT_ROWS; dot++) {
+        layer.row(x, y + Braille_layer::DOT_ROWS + dot, width * Braille_layer::DOT_COLUMNS, color);
+    }
 }
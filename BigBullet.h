@@ -6,12 +6,15 @@
 #define SPACE_INVADERS_BIGBULLET_H
 
 #include <ncurses.h>
-#include "Game_actor.h"
+#include "Bullet.h"
+#include "Memory_stats.h"
 
-class BigBullet : public Game_actor{
+class BigBullet : public Bullet, public Memory_counted<Memory_stats::BIG_BULLET> {
 public:
     BigBullet(short _pos_x, short _pos_y, int _min_x, int _max_x, int _min_y, int _max_y);
-    void drawActor();
+    void drawActor(const Viewport &view);
+    void drawDots(const Viewport &view, Braille_layer &layer, long tick, short color);
+    Bullet* clone() const { return new BigBullet(*this); }
 };
 
 
@@ -0,0 +1,176 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <ncurses.h>
+#include <langinfo.h>
+#include <algorithm>
+#include <cstring>
+#include "Braille_layer.h"
+
+/// The bit of every dot of a cell, by the dot's column and row
+static const uint8_t dot_bits[Braille_layer::DOT_COLUMNS][Braille_layer::DOT_ROWS] = {
+        { 0x01, 0x02, 0x04, 0x40 },
+        { 0x08, 0x10, 0x20, 0x80 } };
+
+std::atomic_bool Braille_layer::enabled(false);
+
+/**
+ * ORs the mask into a run of cells of a row, a word at a time where the run covers whole words.
+ * Every byte of the pattern is the mask, so the order of the bytes in a word doesn't matter.
+ * @param words the row's words
+ * @param from the first cell
+ * @param to the cell after the last one
+ * @param mask the dots
+ */
+static void or_run(uint64_t* words, int from, int to, uint8_t mask) {
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(words);
+    uint64_t pattern = 0x0101010101010101ULL * mask;
+    while (from < to && from % 8 != 0) {
+        bytes[from++] |= mask;
+    }
+    for (; from + 8 <= to; from += 8) {
+        words[from / 8] |= pattern;
+    }
+    while (from < to) {
+        bytes[from++] |= mask;
+    }
+}
+
+Braille_layer::Braille_layer() : columns(0), rows(0), words_per_row(0) {}
+
+/**
+ * Starts a frame with no dots lit
+ * @param _columns the width of the screen
+ * @param _rows the height of the screen
+ */
+void Braille_layer::clear(int _columns, int _rows) {
+    if (_columns != columns || _rows != rows) {
+        columns = _columns;
+        rows = _rows;
+        words_per_row = (columns + CELLS_PER_WORD - 1) / CELLS_PER_WORD;
+        masks.assign((unsigned long) (rows * words_per_row), 0);
+        colors.assign((unsigned long) (rows * columns), 0);
+        return;
+    }
+    std::memset(masks.data(), 0, masks.size() * sizeof(uint64_t));
+}
+
+/**
+ * Lights a vertical run of dots, the part off the screen is left out
+ * @param dot_x the column of the dots, in dots from the left edge of the screen
+ * @param dot_y the top dot, in dots from the top edge of the screen
+ * @param dots the length of the run
+ * @param color the color pair
+ */
+void Braille_layer::column(int dot_x, int dot_y, int dots, short color) {
+    if (dot_x < 0 || dot_x >= columns * DOT_COLUMNS) return;
+    int top = std::max(dot_y, 0);
+    int bottom = std::min(dot_y + dots, rows * DOT_ROWS);
+    int x = dot_x / DOT_COLUMNS;
+    const uint8_t* bits = dot_bits[dot_x % DOT_COLUMNS];
+    int dot = top;
+    while (dot < bottom) {
+        int y = dot / DOT_ROWS;
+        uint8_t mask = 0;
+        for (; dot < bottom && dot / DOT_ROWS == y; dot++) {
+            mask |= bits[dot % DOT_ROWS];
+        }
+        cells(y)[x] |= mask;
+        colors[y * columns + x] = color;
+    }
+}
+
+/**
+ * Lights a horizontal run of dots, the part off the screen is left out
+ * @param dot_x the left dot, in dots from the left edge of the screen
+ * @param dot_y the row of the dots, in dots from the top edge of the screen
+ * @param dots the length of the run
+ * @param color the color pair
+ */
+void Braille_layer::row(int dot_x, int dot_y, int dots, short color) {
+    if (dot_y < 0 || dot_y >= rows * DOT_ROWS) return;
+    int left = std::max(dot_x, 0);
+    int right = std::min(dot_x + dots, columns * DOT_COLUMNS);
+    if (left >= right) return;
+    int y = dot_y / DOT_ROWS;
+    int dot_row = dot_y % DOT_ROWS;
+    uint64_t* words = masks.data() + y * words_per_row;
+    /// The cells at the ends may have only one of their two dots lit, the ones between have both
+    int first = left / DOT_COLUMNS;
+    int last = (right - 1) / DOT_COLUMNS;
+    if (left % DOT_COLUMNS != 0) {
+        or_run(words, first, first + 1, dot_bits[1][dot_row]);
+        first++;
+    }
+    if (right % DOT_COLUMNS != 0 && last >= first) {
+        or_run(words, last, last + 1, dot_bits[0][dot_row]);
+        last--;
+    }
+    or_run(words, first, last + 1, uint8_t(dot_bits[0][dot_row] | dot_bits[1][dot_row]));
+    std::fill(colors.begin() + y * columns + left / DOT_COLUMNS,
+              colors.begin() + y * columns + (right - 1) / DOT_COLUMNS + 1, color);
+}
+
+/**
+ * Lights a single dot, nothing happens off the screen
+ * @param dot_x the dot's column, in dots from the left edge of the screen
+ * @param dot_y the dot's row, in dots from the top edge of the screen
+ * @param color the color pair
+ */
+void Braille_layer::plot(int dot_x, int dot_y, short color) {
+    if (dot_x < 0 || dot_y < 0 || dot_x >= columns * DOT_COLUMNS || dot_y >= rows * DOT_ROWS) return;
+    int x = dot_x / DOT_COLUMNS;
+    int y = dot_y / DOT_ROWS;
+    cells(y)[x] |= dot_bits[dot_x % DOT_COLUMNS][dot_y % DOT_ROWS];
+    colors[y * columns + x] = color;
+}
+
+/**
+ * Prints the lit cells on the standard screen, skipping eight unlit cells at a time.
+ * A cell where a sprite or a text has been printed is left as it is.
+ * @return the number of the printed cells
+ */
+int Braille_layer::draw() {
+    int drawn = 0;
+#ifdef SPACE_INVADERS_BRAILLE
+    for (int y = 0; y < rows; y++) {
+        const uint64_t* words = masks.data() + y * words_per_row;
+        const uint8_t* row_cells = cells(y);
+        for (int word = 0; word < words_per_row; word++) {
+            if (words[word] == 0) continue;
+            int end = std::min((word + 1) * CELLS_PER_WORD, columns);
+            for (int x = word * CELLS_PER_WORD; x < end; x++) {
+                if (row_cells[x] == 0 || (mvinch(y, x) & A_CHARTEXT) != ' ') continue;
+                wchar_t dots[2] = { wchar_t(0x2800 + row_cells[x]), 0 };
+                cchar_t cell;
+                setcchar(&cell, dots, A_BOLD, has_colors() ? colors[y * columns + x] : short(0), nullptr);
+                mvadd_wch(y, x, &cell);
+                drawn++;
+            }
+        }
+    }
+#endif
+    return drawn;
+}
+
+/**
+ * @return true if the game is built with the wide character ncurses and the terminal speaks UTF-8
+ */
+bool Braille_layer::isAvailable() {
+#ifdef SPACE_INVADERS_BRAILLE
+    return std::strcmp(nl_langinfo(CODESET), "UTF-8") == 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Switches the layer on and off, it stays off where it isn't available
+ * @return true if the layer is on now
+ */
+bool Braille_layer::toggle() {
+    if (!isAvailable()) return false;
+    enabled = !enabled;
+    return enabled;
+}
@@ -0,0 +1,59 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_BRAILLE_LAYER_H
+#define SPACE_INVADERS_BRAILLE_LAYER_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Draws the small, fast things at a finer grain than the terminal's cells, on top of the ASCII
+ * sprites. Every cell is a Unicode Braille character of 2 x 4 dots, kept as an 8 bit mask in
+ * the Braille dot order, so the character is U+2800 plus the mask. The actors are composited by
+ * OR-ing their dots into the masks, the masks being packed eight cells to a 64 bit word, so
+ * clearing, horizontal runs and finding the lit cells go a word at a time. Only the lit cells
+ * which the sprites have left blank are printed.
+ * Needs the wide character ncurses and a UTF-8 terminal, otherwise it can't be switched on.
+ */
+class Braille_layer {
+public:
+    static const int DOT_COLUMNS = 2; // dots across a cell
+    static const int DOT_ROWS = 4; // dots down a cell
+
+    Braille_layer();
+
+    void clear(int _columns, int _rows);
+
+    void column(int dot_x, int dot_y, int dots, short color);
+
+    void row(int dot_x, int dot_y, int dots, short color);
+
+    void plot(int dot_x, int dot_y, short color);
+
+    int draw();
+
+    static bool isAvailable();
+
+    static bool toggle();
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+private:
+    static const int CELLS_PER_WORD = 8;
+
+    int columns;
+    int rows;
+    int words_per_row;
+    std::vector<uint64_t> masks; // the dots of every cell, a row of cells takes whole words
+    std::vector<short> colors; // the color pair of every cell, the last actor composited into it wins
+
+    static std::atomic_bool enabled;
+
+    uint8_t* cells(int y) { return reinterpret_cast<uint8_t*>(masks.data() + y * words_per_row); }
+};
+
+
+#endif //SPACE_INVADERS_BRAILLE_LAYER_H
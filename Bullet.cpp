@@ -0,0 +1,87 @@
+//
+// Created by piotrek on 12.06.17.
+//
+
+#include "Bullet.h"
+
+Bullet::Bullet(int _pos_x, int _pos_y, int _width, int _height, int _min_x, int _max_x, int _min_y, int _max_y)
+        : Game_actor(_pos_x, _pos_y, _width, _height, _min_x, _max_x, _min_y, _max_y) {
+    spawn_tick = 0;
+    spawn_y = _pos_y;
+    speed = 1;
+    damage = 1;
+    blast = 0;
+}
+
+/**
+ * Shoots the bullet from its current position
+ * @param tick the time of the shot in milliseconds
+ * @param _speed the bullet's speed in rows per second
+ * @param direction UP or DOWN
+ */
+void Bullet::launch(long tick, int _speed, Direction direction) {
+    spawn_tick = tick;
+    spawn_y = pos_y;
+    speed = _speed;
+    move_direction = direction;
+}
+
+/**
+ * @param tick the time in milliseconds
+ * @return the top row of the bullet at the given time
+ */
+int Bullet::rowAt(long tick) const {
+    long rows = tick > spawn_tick ? (tick - spawn_tick) * speed / 1000 : 0;
+    return move_direction == UP ? spawn_y - int(rows) : spawn_y + int(rows);
+}
+
+/**
+ * @param tick the time in milliseconds
+ * @param dots the number of parts a row is divided into
+ * @return the top of the bullet at the given time, in parts of a row
+ */
+int Bullet::dotRowAt(long tick, int dots) const {
+    long parts = tick > spawn_tick ? (tick - spawn_tick) * speed * dots / 1000 : 0;
+    return move_direction == UP ? spawn_y * dots - int(parts) : spawn_y * dots + int(parts);
+}
+
+/**
+ * @param row the row to be reached
+ * @return the first moment in milliseconds at which the bullet's top is in the given row
+ */
+long Bullet::tickAt(int row) const {
+    long rows = move_direction == UP ? spawn_y - row : row - spawn_y;
+    if (rows <= 0) return spawn_tick;
+    return spawn_tick + (rows * 1000 + speed - 1) / speed;
+}
+
+/**
+ * @return the first row at which the bullet is out of its area
+ */
+int Bullet::exitRow() const {
+    return move_direction == UP ? min_y - 1 : max_y - height + 1;
+}
+
+/**
+ * Moves the bullet to where it is at the given time. The bullet is done once it leaves its area.
+ * @param tick the time in milliseconds
+ * @return the row the bullet was in before
+ */
+int Bullet::advance(long tick) {
+    int previous = pos_y;
+    if (!done) {
+        moveTo(rowAt(tick));
+    }
+    return previous;
+}
+
+/**
+ * Puts the bullet in the given row of its course
+ * @param row the new top row of the bullet
+ */
+void Bullet::moveTo(int row) {
+    pos_y = row;
+    if (move_direction == UP ? pos_y < min_y : pos_y + height > max_y) {
+        done = true;
+    }
+}
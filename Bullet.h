@@ -0,0 +1,53 @@
+//
+// Created by piotrek on 12.06.17.
+//
+
+#ifndef SPACE_INVADERS_BULLET_BASE_H
+#define SPACE_INVADERS_BULLET_BASE_H
+
+#include "Game_actor.h"
+#include "Braille_layer.h"
+
+/**
+ * A bullet flying on a vertical course with a constant speed. Instead of being moved
+ * every step, the bullet remembers when and where it was shot, and its row at any
+ * moment is computed in closed form.
+ */
+class Bullet : public Game_actor {
+protected:
+    long spawn_tick;
+    int spawn_y;
+    int speed;
+    int damage; // hit points taken from the player
+    int blast; // radius of the crater left in a shield
+
+public:
+    Bullet(int _pos_x, int _pos_y, int _width, int _height, int _min_x, int _max_x, int _min_y, int _max_y);
+
+    void launch(long tick, int _speed, Direction direction);
+
+    int rowAt(long tick) const;
+
+    int dotRowAt(long tick, int dots) const;
+
+    long tickAt(int row) const;
+
+    int exitRow() const;
+
+    int advance(long tick);
+
+    void moveTo(int row);
+
+    long getSpawn_tick() const { return spawn_tick; }
+
+    int getDamage() const { return damage; }
+
+    int getBlast() const { return blast; }
+
+    virtual Bullet* clone() const = 0;
+
+    virtual void drawDots(const Viewport &view, Braille_layer &layer, long tick, short color) = 0;
+};
+
+
+#endif //SPACE_INVADERS_BULLET_BASE_H
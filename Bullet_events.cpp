@@ -0,0 +1,68 @@
+//
+// Created by piotrek on 12.06.17.
+//
+
+#include <algorithm>
+#include "Bullet_events.h"
+
+/**
+ * Predicts when the just launched bullet reaches the shields, the player's row
+ * (only the bullets going down) and the end of its course.
+ * @param bullet the bullet
+ * @param shields_top the top row of the shields
+ * @param shields_bottom the bottom row of the shields
+ * @param player_row the row of the player
+ */
+void Bullet_events::track(Bullet* bullet, int shields_top, int shields_bottom, int player_row) {
+    scheduleBand(bullet, SHIELDS, bullet->getPos_y(), shields_top, shields_bottom);
+    if (bullet->move_direction == DOWN) {
+        scheduleBand(bullet, PLAYER, bullet->getPos_y(), player_row, player_row);
+    }
+    int exit_row = bullet->exitRow();
+    Event event = { bullet->tickAt(exit_row), bullet, EXIT, exit_row, exit_row, exit_row };
+    schedule(event);
+}
+
+/**
+ * Queues the event for the first row, starting from from_row, at which the bullet
+ * overlaps the band of rows [first_row, last_row]. Nothing is queued if the bullet
+ * has already passed the band.
+ */
+void Bullet_events::scheduleBand(Bullet* bullet, Kind kind, int from_row, int first_row, int last_row) {
+    int row;
+    if (bullet->move_direction == DOWN) {
+        if (from_row > last_row) return;
+        row = std::max(from_row, first_row - bullet->getHeight() + 1);
+    } else {
+        if (from_row + bullet->getHeight() - 1 < first_row) return;
+        row = std::min(from_row, last_row);
+    }
+    Event event = { bullet->tickAt(row), bullet, kind, row, first_row, last_row };
+    schedule(event);
+}
+
+void Bullet_events::schedule(const Event &event) {
+    mutex.lock();
+    queue.push_back(event);
+    std::push_heap(queue.begin(), queue.end(), std::greater<Event>());
+    mutex.unlock();
+}
+
+/**
+ * Takes the earliest event, if it is due
+ * @param now the current time in milliseconds
+ * @param event the event taken
+ * @return false if there are no events due
+ */
+bool Bullet_events::pop(long now, Event &event) {
+    bool due = false;
+    mutex.lock();
+    if (!queue.empty() && queue.front().tick <= now) {
+        event = queue.front();
+        std::pop_heap(queue.begin(), queue.end(), std::greater<Event>());
+        queue.pop_back();
+        due = true;
+    }
+    mutex.unlock();
+    return due;
+}
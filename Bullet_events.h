@@ -0,0 +1,101 @@
+//
+// Created by piotrek on 12.06.17.
+//
+
+#ifndef SPACE_INVADERS_BULLET_EVENTS_H
+#define SPACE_INVADERS_BULLET_EVENTS_H
+
+#include <vector>
+#include <functional>
+#include <mutex>
+#include "Bullet.h"
+
+/**
+ * Time ordered queue of the predicted bullet events. When a bullet is shot, the moments
+ * at which it reaches the rows of its possible targets are computed and queued,
+ * so each frame handles only the events which are due instead of all the bullets.
+ */
+class Bullet_events {
+public:
+    /// The order matters, EXIT is the last event of a bullet handled at a given moment
+    enum Kind {
+        SHIELDS, PLAYER, EXIT
+    };
+
+    struct Event {
+        long tick;
+        Bullet* bullet;
+        Kind kind;
+        int row; // the bullet's top row at the event
+        int first_row; // the band of rows of the target
+        int last_row;
+
+        bool operator>(const Event &other) const {
+            return tick != other.tick ? tick > other.tick : kind > other.kind;
+        }
+    };
+
+    void track(Bullet* bullet, int shields_top, int shields_bottom, int player_row);
+
+    void scheduleBand(Bullet* bullet, Kind kind, int from_row, int first_row, int last_row);
+
+    /**
+     * Handles all the events which are due. The bullet is put exactly in the row of its event
+     * and hit(event) is called. If it returns true the bullet is done, otherwise the event
+     * for the bullet's next row in the band is queued. EXIT events are passed to hit
+     * even for the bullets which are already done, as they are the last ones of a bullet.
+     * @param now the current time in milliseconds
+     * @param hit the function resolving the event
+     */
+    template <typename F>
+    void process(long now, F hit) {
+        Event event;
+        while (pop(now, event)) {
+            Bullet* bullet = event.bullet;
+            if (event.kind == EXIT) {
+                if (!bullet->isDone()) {
+                    bullet->moveTo(event.row);
+                }
+                hit(event);
+                continue;
+            }
+            if (bullet->isDone()) continue;
+            bullet->moveTo(event.row);
+            if (bullet->isDone()) continue;
+            if (hit(event)) {
+                bullet->setDone();
+            } else {
+                int next_row = event.row + (bullet->move_direction == UP ? -1 : 1);
+                scheduleBand(bullet, event.kind, next_row, event.first_row, event.last_row);
+            }
+        }
+    }
+
+    /**
+     * Replaces the queued events with the events of another queue, which must not be in use.
+     * The bullets are translated with copy, called once for every event.
+     * @param other the queue to be copied
+     * @param copy the function mapping a bullet of the other queue to its copy
+     */
+    template <typename F>
+    void assign(const Bullet_events &other, F copy) {
+        mutex.lock();
+        queue = other.queue;
+        for (Event &event : queue) {
+            event.bullet = copy(event.bullet);
+        }
+        mutex.unlock();
+    }
+
+private:
+    /// Binary heap ordered with std::greater, the earliest event at the front
+    std::vector<Event> queue;
+    std::mutex mutex;
+
+    void schedule(const Event &event);
+
+    bool pop(long now, Event &event);
+};
+
+
+#endif //SPACE_INVADERS_BULLET_EVENTS_H
@@ -0,0 +1,346 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#ifdef SPACE_INVADERS_ZLIB
+#include <zlib.h>
+#endif
+#include "Cast_recorder.h"
+#include "Trace.h"
+
+/// The writer writes the output in chunks at least that big, and checks the ring that often when idle
+static const unsigned long chunk_bytes = 1 << 16;
+static const std::chrono::milliseconds writer_idle(10);
+
+static long nanos() {
+    return (long) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Opens the cast and starts the writer. Must be called after the color pairs are set up.
+ * @param path the file of the recording, gzipped if the name ends with ".gz"
+ * @param columns the width of the terminal
+ * @param rows the height of the terminal
+ */
+Cast_recorder::Cast_recorder(const char* path, int columns, int rows) {
+    head = 0;
+    tail = 0;
+    stopping = false;
+    for (Frame &frame : ring) {
+        frame.changed.reserve((unsigned long) rows);
+        frame.cells.reserve((unsigned long) (columns * rows));
+    }
+    previous_columns = 0;
+    previous_rows = 0;
+    start = nanos();
+    first_capture = 0;
+    last_capture = 0;
+    capture_nanos = 0;
+    frames = 0;
+    dropped = 0;
+
+    file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        std::cerr << "Can't open " << path << std::endl;
+    }
+    unsigned long length = std::strlen(path);
+    compress = length > 3 && std::strcmp(path + length - 3, ".gz") == 0;
+    stream = nullptr;
+#ifdef SPACE_INVADERS_ZLIB
+    if (compress) {
+        z_stream* z = new z_stream();
+        /// 16 more window bits ask for a gzip header, so the file opens with zcat
+        deflateInit2(z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+        stream = z;
+        deflated.resize(chunk_bytes);
+    }
+#else
+    compress = false;
+#endif
+    for (short pair = 0; pair < 16; pair++) {
+        short foreground = -1;
+        short background = -1;
+        palette[pair] = (has_colors() && pair < COLOR_PAIRS && pair_content(pair, &foreground, &background) == OK)
+                        ? foreground : short(-1);
+    }
+    written_columns = columns;
+    written_rows = rows;
+    attributes = -1;
+    raw_bytes = 0;
+    file_bytes = 0;
+    /// Without the file nothing is captured and there is nothing to write
+    if (file != nullptr) {
+        writer = std::thread(&Cast_recorder::run, this);
+    }
+}
+
+Cast_recorder::~Cast_recorder() {
+    stop();
+#ifdef SPACE_INVADERS_ZLIB
+    if (stream != nullptr) {
+        deflateEnd(static_cast<z_stream*>(stream));
+        delete static_cast<z_stream*>(stream);
+    }
+#endif
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+}
+
+/**
+ * Writes the frames left in the ring and finishes the cast. No frame may be captured afterwards.
+ */
+void Cast_recorder::stop() {
+    stopping = true;
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+/**
+ * Puts the rows of the window changed since the last captured frame into the ring.
+ * Must be called by the rendering thread right after the window is refreshed.
+ * Does nothing when the file couldn't be opened.
+ * @param window the window, as big as the terminal
+ */
+void Cast_recorder::capture(WINDOW* window) {
+    if (file == nullptr) return;
+    Trace::Scope scope("capture", "recorder");
+    long begin = nanos();
+    if (first_capture == 0) {
+        first_capture = begin;
+    }
+    frames++;
+    unsigned long slot = tail.load(std::memory_order_relaxed);
+    if (slot - head.load(std::memory_order_acquire) == RING) {
+        dropped++;
+        last_capture = nanos();
+        capture_nanos += last_capture - begin;
+        return;
+    }
+    Frame &frame = ring[slot % RING];
+    int columns = getmaxx(window);
+    int rows = getmaxy(window);
+    frame.full = columns != previous_columns || rows != previous_rows;
+    if (frame.full) {
+        previous.assign((unsigned long) (columns * rows), Cell());
+        row.resize((unsigned long) columns + 1);
+        previous_columns = columns;
+        previous_rows = rows;
+    }
+    frame.columns = columns;
+    frame.rows = rows;
+    frame.changed.clear();
+    frame.cells.clear();
+    int cursor_y, cursor_x;
+    getyx(window, cursor_y, cursor_x);
+    for (int y = 0; y < rows; y++) {
+#ifdef SPACE_INVADERS_BRAILLE
+        mvwin_wchnstr(window, y, 0, row.data(), columns);
+#else
+        mvwinchnstr(window, y, 0, row.data(), columns);
+#endif
+        Cell* seen = previous.data() + y * columns;
+        if (frame.full || std::memcmp(seen, row.data(), columns * sizeof(Cell)) != 0) {
+            std::memcpy(seen, row.data(), columns * sizeof(Cell));
+            frame.changed.push_back(y);
+            frame.cells.insert(frame.cells.end(), row.begin(), row.begin() + columns);
+        }
+    }
+    wmove(window, cursor_y, cursor_x);
+    if (!frame.changed.empty()) {
+        frame.micros = (begin - start) / 1000;
+        tail.store(slot + 1, std::memory_order_release);
+    }
+    last_capture = nanos();
+    capture_nanos += last_capture - begin;
+}
+
+/**
+ * Prints how many frames were recorded and how much of the frame time the capturing took.
+ * Must be called after the recorder is stopped.
+ * @param out the stream
+ */
+void Cast_recorder::printStats(std::ostream &out) const {
+    if (file == nullptr) {
+        out << "recorder: nothing recorded, the file couldn't be opened" << std::endl;
+        return;
+    }
+    long elapsed = last_capture - first_capture;
+    out << "recorder: " << frames << " frames captured, " << dropped << " dropped, "
+        << raw_bytes << " bytes recorded, " << file_bytes << " bytes written" << std::endl;
+    out << "recorder: " << (frames > 0 ? capture_nanos / frames / 1000.0 : 0.0) << " us per frame, "
+        << (elapsed > 0 ? 100.0 * capture_nanos / elapsed : 0.0) << "% of the frame time" << std::endl;
+}
+
+/**
+ * The writer thread: writes the header, then the frames as they come
+ */
+void Cast_recorder::run() {
+    Trace::nameThread("recorder");
+    char header[256];
+    std::snprintf(header, sizeof(header), "{\"version\": 2, \"width\": %d, \"height\": %d, \"timestamp\": %ld, "
+            "\"title\": \"Space Invaders\", \"env\": {\"TERM\": \"xterm\"}}\n",
+                  written_columns, written_rows, (long) std::time(nullptr));
+    pending += header;
+    while (true) {
+        unsigned long slot = head.load(std::memory_order_relaxed);
+        if (slot == tail.load(std::memory_order_acquire)) {
+            if (stopping) break;
+            std::this_thread::sleep_for(writer_idle);
+            continue;
+        }
+        encode(ring[slot % RING]);
+        head.store(slot + 1, std::memory_order_release);
+        if (pending.size() >= chunk_bytes) {
+            flush(false);
+        }
+    }
+    flush(true);
+}
+
+/**
+ * Turns a frame into an output event, preceded by a resize event when the terminal has changed
+ * @param frame the frame
+ */
+void Cast_recorder::encode(const Frame &frame) {
+    Trace::Scope scope("encode", "recorder");
+    char stamp[64];
+    double seconds = frame.micros / 1000000.0;
+    if (frame.columns != written_columns || frame.rows != written_rows) {
+        std::snprintf(stamp, sizeof(stamp), "[%.6f, \"r\", \"%dx%d\"]\n", seconds, frame.columns, frame.rows);
+        pending += stamp;
+        written_columns = frame.columns;
+        written_rows = frame.rows;
+    }
+    std::string text;
+    if (frame.full) {
+        text += "\x1b[0m\x1b[H\x1b[2J";
+        attributes = 0;
+    }
+    for (unsigned long i = 0; i < frame.changed.size(); i++) {
+        std::snprintf(stamp, sizeof(stamp), "\x1b[%d;1H", frame.changed[i] + 1);
+        text += stamp;
+        appendRow(text, frame.cells.data() + i * frame.columns, frame.columns);
+    }
+    std::snprintf(stamp, sizeof(stamp), "[%.6f, \"o\", ", seconds);
+    pending += stamp;
+    appendJson(text);
+    pending += "]\n";
+}
+
+/**
+ * @param cell a cell of the screen
+ * @param attributes set to the cell's attributes, the color pair included
+ * @return the cell's character
+ */
+#ifdef SPACE_INVADERS_BRAILLE
+static unsigned int split_cell(const cchar_t &cell, int &attributes) {
+    wchar_t characters[CCHARW_MAX + 1];
+    attr_t attrs = 0;
+    short pair = 0;
+    getcchar(&cell, characters, &attrs, &pair, nullptr);
+    attributes = int((attrs & A_ATTRIBUTES & ~A_COLOR) | COLOR_PAIR(pair));
+    return (unsigned int) characters[0];
+}
+#else
+static unsigned int split_cell(const chtype &cell, int &attributes) {
+    attributes = int(cell & A_ATTRIBUTES);
+    return cell & A_CHARTEXT;
+}
+#endif
+
+/**
+ * Appends the cells of a row, switching the attributes only where they change.
+ * The blank end of the row is erased instead of written. Braille characters are written in UTF-8.
+ */
+void Cast_recorder::appendRow(std::string &text, const Cell* cells, int columns) {
+    int end = columns;
+    int attributes_of_cell;
+    while (end > 0 && split_cell(cells[end - 1], attributes_of_cell) == ' ' && attributes_of_cell == 0) {
+        end--;
+    }
+    for (int x = 0; x <= end; x++) {
+        unsigned int character = x < end ? split_cell(cells[x], attributes_of_cell) : 0;
+        int wanted = x < end ? attributes_of_cell : 0;
+        if (wanted != attributes) {
+            text += "\x1b[0";
+            if (wanted & A_BOLD) text += ";1";
+            if (wanted & A_UNDERLINE) text += ";4";
+            if (wanted & A_REVERSE) text += ";7";
+            int pair = PAIR_NUMBER(wanted);
+            if (pair > 0 && pair < 16 && palette[pair] >= 0 && palette[pair] < 8) {
+                text += ";3";
+                text += char('0' + palette[pair]);
+            }
+            text += 'm';
+            attributes = wanted;
+        }
+        if (x == end) break;
+        if (character >= 0x2800 && character < 0x2900) {
+            text += char(0xe0 | (character >> 12));
+            text += char(0x80 | ((character >> 6) & 0x3f));
+            text += char(0x80 | (character & 0x3f));
+        } else {
+            text += character >= 32 && character < 127 ? char(character) : ' ';
+        }
+    }
+    if (end < columns) {
+        text += "\x1b[K";
+    }
+}
+
+/**
+ * Appends the text as a JSON string
+ */
+void Cast_recorder::appendJson(const std::string &text) {
+    pending += '"';
+    for (char character : text) {
+        if (character == '"' || character == '\\') {
+            pending += '\\';
+            pending += character;
+        } else if ((unsigned char) character < 32) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char) character);
+            pending += escaped;
+        } else {
+            pending += character;
+        }
+    }
+    pending += '"';
+}
+
+/**
+ * Writes the pending output, compressing it on the way when asked to
+ * @param finish true at the end of the recording
+ */
+void Cast_recorder::flush(bool finish) {
+    Trace::Scope scope("flush", "recorder");
+    raw_bytes += pending.size();
+#ifdef SPACE_INVADERS_ZLIB
+    if (compress) {
+        z_stream* z = static_cast<z_stream*>(stream);
+        z->next_in = (Bytef*) pending.data();
+        z->avail_in = (uInt) pending.size();
+        int result;
+        do {
+            z->next_out = (Bytef*) deflated.data();
+            z->avail_out = (uInt) deflated.size();
+            result = deflate(z, finish ? Z_FINISH : Z_NO_FLUSH);
+            unsigned long produced = deflated.size() - z->avail_out;
+            file_bytes += std::fwrite(deflated.data(), 1, produced, file);
+        } while (z->avail_out == 0 || (finish && result != Z_STREAM_END && result != Z_STREAM_ERROR));
+        pending.clear();
+        if (finish) std::fflush(file);
+        return;
+    }
+#endif
+    file_bytes += std::fwrite(pending.data(), 1, pending.size(), file);
+    pending.clear();
+    if (finish) std::fflush(file);
+}
@@ -0,0 +1,103 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_CAST_RECORDER_H
+#define SPACE_INVADERS_CAST_RECORDER_H
+
+#include <atomic>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ncurses.h>
+
+/**
+ * Records the session as an asciinema v2 cast. After every refresh the rendering thread
+ * compares the screen with the last captured frame and copies only the changed rows into
+ * a slot of a bounded lock free ring, without allocating, formatting or waiting. A writer
+ * thread turns the rows into timed terminal output, gzips it when the file name ends
+ * with ".gz", and writes it in large chunks. A frame which finds the ring full is dropped
+ * and the next one is compared with the last frame which made it into the ring.
+ * Built for the Braille mode, the cells are read as wide characters.
+ */
+class Cast_recorder {
+public:
+    static const unsigned long RING = 128; // frames, a power of two
+
+    Cast_recorder(const char* path, int columns, int rows);
+
+    ~Cast_recorder();
+
+    void capture(WINDOW* window);
+
+    void stop();
+
+    void printStats(std::ostream &out) const;
+
+private:
+#ifdef SPACE_INVADERS_BRAILLE
+    typedef cchar_t Cell;
+#else
+    typedef chtype Cell;
+#endif
+
+    /**
+     * The changed rows of one frame, every row is columns cells long
+     */
+    struct Frame {
+        long micros; // since the start of the recording
+        int columns;
+        int rows;
+        bool full; // every row is in the frame, the screen is cleared first
+        std::vector<int> changed;
+        std::vector<Cell> cells;
+    };
+
+    Frame ring[RING];
+    std::atomic<unsigned long> head; // the next frame to be written, advanced by the writer
+    std::atomic<unsigned long> tail; // the next free slot, advanced by the rendering thread
+    std::atomic<bool> stopping;
+    std::thread writer;
+
+    /// Touched only by the rendering thread
+    std::vector<Cell> previous; // the last frame put into the ring
+    std::vector<Cell> row;
+    int previous_columns;
+    int previous_rows;
+    long start;
+    long first_capture;
+    long last_capture;
+    long capture_nanos;
+    long frames;
+    long dropped;
+
+    /// Touched only by the writer thread
+    FILE* file;
+    bool compress;
+    void* stream; // the deflate state when compressing
+    short palette[16]; // the foreground color of every color pair
+    std::string pending; // the output not written yet
+    std::vector<char> deflated;
+    int written_columns;
+    int written_rows;
+    int attributes; // the attributes in effect in the recording, -1 when unknown
+
+    /// Read after the writer has finished
+    long raw_bytes;
+    long file_bytes;
+
+    void run();
+
+    void encode(const Frame &frame);
+
+    void appendRow(std::string &text, const Cell* cells, int columns);
+
+    void appendJson(const std::string &text);
+
+    void flush(bool finish);
+};
+
+
+#endif //SPACE_INVADERS_CAST_RECORDER_H
@@ -0,0 +1,124 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <atomic>
+#include <algorithm>
+#include "Command_buffer.h"
+
+/**
+ * The commands a thread has recorded since its last submission
+ */
+struct Command_batch {
+    std::vector<Command_buffer::Command> commands;
+    Command_batch* next;
+};
+
+/// The submitted batches, a lock free stack emptied at once by the applying thread
+static std::atomic<Command_batch*> submitted(nullptr);
+static std::atomic<int> threads(0);
+
+/// Touched only by the applying thread
+static std::vector<Command_buffer::Command> applied;
+
+struct Command_thread {
+    int id;
+    int sequence;
+    Command_batch* batch;
+};
+
+static Command_thread &command_thread() {
+    thread_local Command_thread state = { threads++, 0, nullptr };
+    if (state.batch == nullptr) {
+        state.batch = new Command_batch();
+    }
+    return state;
+}
+
+static void record(Command_buffer::Kind kind, int target, Game_actor* actor, int amount) {
+    Command_thread &state = command_thread();
+    state.batch->commands.push_back({ kind, target, 0, state.id, state.sequence++, actor, amount });
+}
+
+/**
+ * Commands are applied by kind and target, then in the order they were submitted,
+ * so spawns come before the damage and every collection is changed in a single run
+ */
+bool Command_buffer::Command::operator<(const Command &other) const {
+    if (kind != other.kind) return kind < other.kind;
+    if (target != other.target) return target < other.target;
+    if (tick != other.tick) return tick < other.tick;
+    if (thread != other.thread) return thread < other.thread;
+    return sequence < other.sequence;
+}
+
+/**
+ * Makes room for the commands about to be recorded by the calling thread
+ * @param commands the number of the commands
+ */
+void Command_buffer::reserve(unsigned long commands) {
+    Command_thread &state = command_thread();
+    state.batch->commands.reserve(state.batch->commands.size() + commands);
+}
+
+/**
+ * Adds a new actor to the target collection. Until then the actor is seen only by the calling thread.
+ * @param target the collection
+ * @param actor the actor
+ */
+void Command_buffer::spawn(int target, Game_actor* actor) {
+    record(SPAWN, target, actor, 0);
+}
+
+/**
+ * Takes hit points from an actor of the target collection
+ * @param target the collection
+ * @param actor the actor
+ * @param amount the hit points
+ */
+void Command_buffer::damage(int target, Game_actor* actor, int amount) {
+    record(DAMAGE, target, actor, amount);
+}
+
+/**
+ * Marks an actor of the target collection done, to be removed with the others
+ * @param target the collection
+ * @param actor the actor
+ */
+void Command_buffer::destroy(int target, Game_actor* actor) {
+    record(DESTROY, target, actor, 0);
+}
+
+/**
+ * Hands the commands recorded by the calling thread over to the applying thread
+ * @param tick the current time in milliseconds
+ */
+void Command_buffer::submit(long tick) {
+    Command_thread &state = command_thread();
+    Command_batch* batch = state.batch;
+    if (batch->commands.empty()) return;
+    for (Command &command : batch->commands) {
+        command.tick = tick;
+    }
+    batch->next = submitted.load(std::memory_order_relaxed);
+    while (!submitted.compare_exchange_weak(batch->next, batch, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+    state.batch = nullptr;
+}
+
+/**
+ * Collects the submitted batches into a single sorted vector, valid until the next call
+ */
+const std::vector<Command_buffer::Command> &Command_buffer::take() {
+    applied.clear();
+    Command_batch* batch = submitted.exchange(nullptr, std::memory_order_acquire);
+    while (batch != nullptr) {
+        Command_batch* next = batch->next;
+        applied.insert(applied.end(), batch->commands.begin(), batch->commands.end());
+        delete batch;
+        batch = next;
+    }
+    std::sort(applied.begin(), applied.end());
+    return applied;
+}
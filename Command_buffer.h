@@ -0,0 +1,72 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_COMMAND_BUFFER_H
+#define SPACE_INVADERS_COMMAND_BUFFER_H
+
+#include <vector>
+#include "Game_actor.h"
+
+/**
+ * Structural changes of the world deferred to the end of the frame. Every thread records
+ * its commands into a buffer of its own without any lock and submits the buffer with
+ * a single atomic exchange. The rendering thread takes all the submitted commands at
+ * the frame's boundary, sorts them and applies them in one pass, grouped by their kind
+ * and target, so every shared vector is locked and grown once per frame.
+ */
+class Command_buffer {
+public:
+    enum Kind { SPAWN, DAMAGE, DESTROY };
+
+    struct Command {
+        Kind kind;
+        int target; // which of the caller's collections the actor belongs to
+        long tick; // when the command's buffer was submitted
+        int thread;
+        int sequence; // order of recording within the thread
+        Game_actor* actor;
+        int amount;
+
+        bool operator<(const Command &other) const;
+    };
+
+    static void reserve(unsigned long commands);
+
+    static void spawn(int target, Game_actor* actor);
+
+    static void damage(int target, Game_actor* actor, int amount);
+
+    static void destroy(int target, Game_actor* actor);
+
+    static void submit(long tick);
+
+    /**
+     * Takes all the submitted commands and applies them in their order.
+     * Must be called by a single thread.
+     * @param run the function applying a run of commands of the same kind and target,
+     *            called with pointers to the run's first command and past its last one
+     * @return the number of the commands applied
+     */
+    template <typename F>
+    static unsigned long apply(F run) {
+        const std::vector<Command> &commands = take();
+        unsigned long first = 0;
+        while (first < commands.size()) {
+            unsigned long last = first + 1;
+            while (last < commands.size() && commands[last].kind == commands[first].kind
+                   && commands[last].target == commands[first].target) {
+                last++;
+            }
+            run(commands.data() + first, commands.data() + last);
+            first = last;
+        }
+        return commands.size();
+    }
+
+private:
+    static const std::vector<Command> &take();
+};
+
+
+#endif //SPACE_INVADERS_COMMAND_BUFFER_H
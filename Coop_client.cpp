@@ -0,0 +1,190 @@
+//
+// Created by piotrek on 17.06.17.
+//
+
+#include <chrono>
+#include <thread>
+#include <ncurses.h>
+#include <poll.h>
+#include "Coop_client.h"
+#include "Game_rules.h"
+
+/**
+ * @param _path the path of the server's socket
+ * @param _policy the policy choosing the player's actions
+ * @param _bot true if the policy doesn't read the keyboard itself
+ */
+Coop_client::Coop_client(const char* _path, Policy* _policy, bool _bot) {
+    path = _path;
+    policy = _policy;
+    bot = _bot;
+    server = nullptr;
+    player = 0;
+    players = 0;
+    confirmed = nullptr;
+    predicted = nullptr;
+    confirmed_frames = 0;
+    last_confirmed.fill(ACTION_NONE);
+    rollbacks = 0;
+    resimulated_frames = 0;
+    desyncs = 0;
+}
+
+Coop_client::~Coop_client() {
+    delete server;
+    delete confirmed;
+    delete predicted;
+}
+
+/**
+ * Joins the game and plays it until it is over, the server leaves or the player quits.
+ * ncurses must be initialized.
+ * @return the exit code of the program
+ */
+int Coop_client::run() {
+    int fd = Net_channel::connect(path);
+    if (fd < 0) return 1;
+    server = new Net_channel(fd);
+    Net_message welcome;
+    while (!server->receive(welcome) || welcome.type != Net_message::WELCOME) {
+        if (server->isClosed()) return 1;
+        mvprintw(0, 0, "Waiting for the other players...");
+        refresh();
+        pollfd waiting = { server->getFd(), POLLIN, 0 };
+        poll(&waiting, 1, 100);
+    }
+    player = welcome.player;
+    players = welcome.players;
+    confirmed = new World(welcome.columns, welcome.rows, welcome.seed, players);
+    predicted = new World(*confirmed);
+
+    Viewport view(getmaxx(stdscr), getmaxy(stdscr), welcome.columns, welcome.rows);
+    std::vector<unsigned char> cells((unsigned long) (welcome.columns * welcome.rows));
+    int hit_points = 0;
+    Observation observation(cells.data(), &hit_points, welcome.columns, welcome.rows);
+    predicted->observe(observation, player);
+    timeout(0);
+
+    std::chrono::steady_clock::time_point next_frame = std::chrono::steady_clock::now();
+    while (!confirmed->isOver() && !server->isClosed()) {
+        if (bot && getch() == 'q') break;
+        Action action = policy->act(observation);
+        if (action == ACTION_QUIT) break;
+
+        /// The own action is shown in this very frame, unless the server is too far behind
+        if (!predicted->isOver() && int(guesses.size()) < MAX_PREDICTION) {
+            Actions actions;
+            actions.fill(ACTION_NONE);
+            for (int i = 0; i < players; i++) {
+                actions[i] = guess(i);
+            }
+            actions[player] = action;
+            guesses.push_back(actions);
+            predicted->step(actions.data());
+
+            Net_message input = {};
+            input.type = Net_message::INPUT;
+            input.frame = confirmed_frames + int(guesses.size()) - 1;
+            input.player = player;
+            input.actions[0] = uint8_t(action);
+            server->send(input);
+        }
+        if (receiveConfirms()) {
+            rollback();
+        }
+
+        predicted->observe(observation, player);
+        view.resize(getmaxx(stdscr), getmaxy(stdscr));
+        view.follow(predicted->getPlayer(player));
+        draw(view);
+        next_frame += frame_durtion;
+        std::this_thread::sleep_until(next_frame);
+    }
+    if (confirmed->isOver()) {
+        *predicted = *confirmed;
+        draw(view);
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+    }
+    return 0;
+}
+
+/**
+ * Prints how much the prediction has missed
+ */
+void Coop_client::printStats(std::ostream &out) const {
+    out << "player " << player + 1 << " of " << players
+        << ", confirmed frames " << confirmed_frames
+        << ", rollbacks " << rollbacks
+        << ", resimulated frames " << resimulated_frames
+        << ", desyncs " << desyncs << std::endl;
+}
+
+/**
+ * @return the predicted action of another player: the last confirmed one, but never a shot
+ */
+Action Coop_client::guess(int other) const {
+    return last_confirmed[other] == ACTION_FIRE ? ACTION_NONE : last_confirmed[other];
+}
+
+/**
+ * Steps the confirmed world through all the confirmed frames which have arrived
+ * @return true if any of the guesses has been wrong
+ */
+bool Coop_client::receiveConfirms() {
+    bool missed = false;
+    Net_message message;
+    while (server->receive(message)) {
+        if (message.type != Net_message::CONFIRM || message.frame != confirmed_frames) continue;
+        Actions actions;
+        actions.fill(ACTION_NONE);
+        for (int i = 0; i < players; i++) {
+            actions[i] = Action(message.actions[i]);
+        }
+        confirmed->step(actions.data());
+        if (confirmed->checksum() != message.checksum) {
+            desyncs++;
+        }
+        if (guesses.empty()) {
+            /// The server has gone on without this player's input
+            missed = true;
+        } else {
+            missed = missed || guesses.front() != actions;
+            guesses.pop_front();
+        }
+        last_confirmed = actions;
+        confirmed_frames++;
+    }
+    return missed;
+}
+
+/**
+ * Restores the predicted world from the confirmed one and simulates the unconfirmed frames again,
+ * with the player's own actions and fresh guesses for the others
+ */
+void Coop_client::rollback() {
+    *predicted = *confirmed;
+    for (Actions &actions : guesses) {
+        for (int i = 0; i < players; i++) {
+            if (i != player) {
+                actions[i] = guess(i);
+            }
+        }
+        predicted->step(actions.data());
+    }
+    rollbacks++;
+    resimulated_frames += guesses.size();
+}
+
+void Coop_client::draw(const Viewport &view) {
+    clear();
+    attron( A_BOLD );
+    predicted->draw(view);
+    attroff( A_BOLD );
+    mvprintw(0, 0, "HEALTH: %d", predicted->getHit_points(player));
+    mvprintw(1, 0, "TOTAL SCORE: %d", predicted->getPoints());
+    mvprintw(2, 0, "Player %d of %d, %d frames unconfirmed", player + 1, players, int(guesses.size()));
+    if (predicted->isOver()) {
+        mvprintw(view.getRows() / 2, view.getColumns() / 2 - 5, "GAME OVER!");
+    }
+    refresh();
+}
@@ -0,0 +1,64 @@
+//
+// Created by piotrek on 17.06.17.
+//
+
+#ifndef SPACE_INVADERS_COOP_CLIENT_H
+#define SPACE_INVADERS_COOP_CLIENT_H
+
+#include <array>
+#include <deque>
+#include <ostream>
+#include <vector>
+#include "World.h"
+#include "Policy.h"
+#include "Net_channel.h"
+
+/**
+ * A player of the co-op game. The client never waits for the server: its own action is
+ * applied to the predicted world in the frame it was taken, and the other players are
+ * assumed to keep moving the way they did in the last confirmed frame. The confirmed frames
+ * are stepped on a separate world; when a confirmed action differs from the guess,
+ * the predicted world is restored from the confirmed one and the unconfirmed frames
+ * are simulated again.
+ */
+class Coop_client {
+public:
+    static const int MAX_PREDICTION = 16; // frames ahead of the server
+
+    Coop_client(const char* _path, Policy* _policy, bool _bot);
+
+    ~Coop_client();
+
+    int run();
+
+    void printStats(std::ostream &out) const;
+
+private:
+    typedef std::array<Action, Net_message::MAX_PLAYERS> Actions;
+
+    const char* path;
+    Policy* policy;
+    bool bot; // the keyboard is only checked for 'q'
+    Net_channel* server;
+    int player;
+    int players;
+    World* confirmed; // the world after confirmed_frames frames
+    World* predicted; // the world after confirmed_frames + guesses.size() frames
+    int confirmed_frames;
+    std::deque<Actions> guesses; // the actions used for the unconfirmed frames
+    Actions last_confirmed;
+    long rollbacks;
+    long resimulated_frames;
+    long desyncs;
+
+    Action guess(int other) const;
+
+    bool receiveConfirms();
+
+    void rollback();
+
+    void draw(const Viewport &view);
+};
+
+
+#endif //SPACE_INVADERS_COOP_CLIENT_H
@@ -0,0 +1,149 @@
+//
+// Created by piotrek on 17.06.17.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "Coop_server.h"
+#include "Game_rules.h"
+
+/**
+ * @param _path the path of the socket to listen on
+ * @param _players the number of players to wait for
+ * @param _seed the seed of the world
+ * @param _columns the width of the world
+ * @param _rows the height of the world
+ */
+Coop_server::Coop_server(const char* _path, int _players, unsigned int _seed, int _columns, int _rows)
+        : world(_columns, _rows, _seed, _players) {
+    path = _path;
+    players = _players;
+    seed = _seed;
+    inputs.resize((unsigned long) players);
+}
+
+Coop_server::~Coop_server() {
+    for (Net_channel* client : clients) {
+        delete client;
+    }
+}
+
+/**
+ * Plays the game until it is over or all the players have left
+ * @return the exit code of the program
+ */
+int Coop_server::run() {
+    int sock = Net_channel::listen(path);
+    if (sock < 0) {
+        std::cerr << "Can't listen on " << path << std::endl;
+        return 1;
+    }
+    std::cout << "Waiting for " << players << " players on " << path << std::endl;
+    while (int(clients.size()) < players) {
+        int fd = accept(sock, nullptr, nullptr);
+        if (fd < 0) continue;
+        clients.push_back(new Net_channel(fd));
+        std::cout << "Player " << clients.size() << " joined" << std::endl;
+    }
+    close(sock);
+    unlink(path);
+
+    Net_message welcome = {};
+    welcome.type = Net_message::WELCOME;
+    welcome.players = players;
+    welcome.seed = seed;
+    welcome.columns = world.getColumns();
+    welcome.rows = world.getRows();
+    for (int i = 0; i < players; i++) {
+        welcome.player = i;
+        clients[i]->send(welcome);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<Action> actions((unsigned long) players);
+    int frame = 0;
+    while (!world.isOver()) {
+        bool connected = false;
+        for (Net_channel* client : clients) {
+            connected = connected || !client->isClosed();
+        }
+        if (!connected) break;
+
+        std::chrono::steady_clock::time_point deadline = start + frame_durtion * (frame + 1 + MAX_INPUT_WAIT);
+        bool ready = true;
+        for (int i = 0; i < players; i++) {
+            ready = ready && inputReady(i, frame);
+        }
+        if (!ready && std::chrono::steady_clock::now() < deadline) {
+            /// Wait for any input, but not past the frame's deadline
+            std::vector<pollfd> fds;
+            for (Net_channel* client : clients) {
+                if (!client->isClosed()) {
+                    fds.push_back({ client->getFd(), POLLIN, 0 });
+                }
+            }
+            long wait = (long) std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()).count();
+            poll(fds.data(), fds.size(), int(std::max(1l, wait)));
+            receiveInputs();
+            continue;
+        }
+
+        Net_message confirm = {};
+        confirm.type = Net_message::CONFIRM;
+        confirm.frame = frame;
+        confirm.players = players;
+        for (int i = 0; i < players; i++) {
+            actions[i] = takeInput(i, frame);
+            confirm.actions[i] = uint8_t(actions[i]);
+        }
+        world.step(actions.data());
+        confirm.checksum = world.checksum();
+        for (Net_channel* client : clients) {
+            client->send(confirm);
+        }
+        frame++;
+    }
+    std::cout << "Game over after " << frame << " frames, score " << world.getPoints() << std::endl;
+    return 0;
+}
+
+/**
+ * Reads all the inputs which have arrived
+ */
+void Coop_server::receiveInputs() {
+    Net_message message;
+    for (int i = 0; i < players; i++) {
+        while (clients[i]->receive(message)) {
+            if (message.type == Net_message::INPUT && message.actions[0] < ACTION_QUIT) {
+                inputs[i][message.frame] = Action(message.actions[0]);
+            }
+        }
+    }
+}
+
+/**
+ * @return true if the player's action for the frame is known, or will never come
+ */
+bool Coop_server::inputReady(int player, int frame) const {
+    return clients[player]->isClosed() || (!inputs[player].empty() && inputs[player].begin()->first <= frame);
+}
+
+/**
+ * Takes the earliest input of the player which isn't meant for a later frame.
+ * Late inputs are used one per frame, in their order.
+ * @return the action or ACTION_NONE if there is no input for the frame
+ */
+Action Coop_server::takeInput(int player, int frame) {
+    std::map<int, Action> &queued = inputs[player];
+    if (queued.empty() || queued.begin()->first > frame) {
+        return ACTION_NONE;
+    }
+    Action action = queued.begin()->second;
+    queued.erase(queued.begin());
+    return action;
+}
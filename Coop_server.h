@@ -0,0 +1,48 @@
+//
+// Created by piotrek on 17.06.17.
+//
+
+#ifndef SPACE_INVADERS_COOP_SERVER_H
+#define SPACE_INVADERS_COOP_SERVER_H
+
+#include <map>
+#include <vector>
+#include "World.h"
+#include "Net_channel.h"
+
+/**
+ * The authoritative co-op game. It waits for all the players to connect, then simulates
+ * the frames one by one: a frame is stepped as soon as the inputs of all the players
+ * for it have arrived, or when it is MAX_INPUT_WAIT frames late, in which case the missing
+ * inputs are taken as ACTION_NONE and the late ones are moved to the next frames.
+ * The actions used and the checksum of the resulting world are sent to all the clients.
+ */
+class Coop_server {
+public:
+    static const int MAX_INPUT_WAIT = 8;
+
+    Coop_server(const char* _path, int _players, unsigned int _seed, int _columns, int _rows);
+
+    ~Coop_server();
+
+    int run();
+
+    const World &getWorld() const { return world; }
+
+private:
+    const char* path;
+    int players;
+    unsigned int seed;
+    World world;
+    std::vector<Net_channel*> clients;
+    std::vector<std::map<int, Action>> inputs; // [player] frame -> action
+
+    void receiveInputs();
+
+    bool inputReady(int player, int frame) const;
+
+    Action takeInput(int player, int frame);
+};
+
+
+#endif //SPACE_INVADERS_COOP_SERVER_H
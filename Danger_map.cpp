@@ -0,0 +1,105 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <algorithm>
+#include <climits>
+#include "Danger_map.h"
+
+/**
+ * @param _columns the width of the world
+ */
+Danger_map::Danger_map(int _columns) {
+    columns = _columns;
+    bullets.resize((unsigned long) columns);
+}
+
+/**
+ * Adds the just launched bullet to the columns it covers
+ * @param bullet the bullet, flying up
+ */
+void Danger_map::add(Bullet* bullet) {
+    int first = std::max(0, bullet->getPos_x());
+    int last = std::min(columns, bullet->getPos_x() + bullet->getWidth());
+    for (int x = first; x < last; x++) {
+        bullets[x].push_back(bullet);
+    }
+}
+
+/**
+ * Removes the bullet, found by its launch time
+ * @param bullet the bullet which is done
+ */
+void Danger_map::remove(Bullet* bullet) {
+    int first = std::max(0, bullet->getPos_x());
+    int last = std::min(columns, bullet->getPos_x() + bullet->getWidth());
+    for (int x = first; x < last; x++) {
+        std::deque<Bullet*> &column = bullets[x];
+        std::deque<Bullet*>::iterator it = std::lower_bound(column.begin(), column.end(), bullet,
+                [](const Bullet* a, const Bullet* b) { return a->getSpawn_tick() < b->getSpawn_tick(); });
+        while (it != column.end() && *it != bullet) it++;
+        if (it != column.end()) {
+            column.erase(it);
+        }
+    }
+}
+
+/**
+ * Forgets all the bullets, keeping the memory of the columns which are still there
+ * @param _columns the width of the world
+ */
+void Danger_map::reset(int _columns) {
+    columns = _columns;
+    bullets.resize((unsigned long) columns);
+    for (std::deque<Bullet*> &column : bullets) {
+        column.clear();
+    }
+}
+
+/**
+ * @param x the column
+ * @param row the row
+ * @param now the current time in milliseconds
+ * @return milliseconds until the next bullet of the column reaches the row, LONG_MAX if none will
+ */
+long Danger_map::timeToImpact(int x, int row, long now) const {
+    if (x < 0 || x >= columns) return LONG_MAX;
+    const std::deque<Bullet*> &column = bullets[x];
+    /// The bullets which have already flown past the row are at the front
+    std::deque<Bullet*>::const_iterator next = std::partition_point(column.begin(), column.end(),
+            [row, now](const Bullet* bullet) { return bullet->rowAt(now) + bullet->getHeight() <= row; });
+    if (next == column.end()) return LONG_MAX;
+    return std::max(0l, (*next)->tickAt(row) - now);
+}
+
+/**
+ * Chooses the way out for an actor moving sideways. The columns under the actor
+ * whose bullets would reach its bottom row before it could move its width away
+ * are the threat; the actor goes the way which clears all of them in fewer columns.
+ * @param actor the actor
+ * @param now the current time in milliseconds
+ * @param milis_per_column how long the actor takes to move one column
+ * @return the direction to move in, the actor's own direction if nothing threatens it
+ */
+Direction Danger_map::evade(const Game_actor &actor, long now, int milis_per_column) const {
+    int x = actor.getPos_x();
+    int width = actor.getWidth();
+    int bottom = actor.getPos_y() + actor.getHeight() - 1;
+    long horizon = long(milis_per_column) * (width + 1);
+    int first_threat = -1;
+    int last_threat = -1;
+    for (int column = x; column < x + width; column++) {
+        if (timeToImpact(column, bottom, now) <= horizon) {
+            if (first_threat < 0) first_threat = column;
+            last_threat = column;
+        }
+    }
+    if (first_threat < 0) return actor.move_direction;
+    int left = x + width - first_threat; // columns to move left until the threats are on the right
+    int right = last_threat - x + 1;
+    bool can_go_left = x - left >= 0;
+    bool can_go_right = x + width + right <= columns;
+    if (can_go_left && (!can_go_right || left < right)) return LEFT;
+    if (can_go_right && (!can_go_left || right < left)) return RIGHT;
+    return actor.move_direction;
+}
@@ -0,0 +1,40 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_DANGER_MAP_H
+#define SPACE_INVADERS_DANGER_MAP_H
+
+#include <deque>
+#include <vector>
+#include "Bullet.h"
+#include "Direction.h"
+
+/**
+ * The player's bullets by column, for the enemies to see what is coming. Every column keeps
+ * its bullets in the order they were shot. They all start in the player's row at the same speed,
+ * so that is also the order of their heights, and the next bullet to reach a row is found
+ * by a binary search. Bullets are added when shot and removed when done; their flight
+ * is computed from their trajectories, so moving them costs nothing here.
+ */
+class Danger_map {
+public:
+    explicit Danger_map(int _columns);
+
+    void add(Bullet* bullet);
+
+    void remove(Bullet* bullet);
+
+    void reset(int _columns);
+
+    long timeToImpact(int x, int row, long now) const;
+
+    Direction evade(const Game_actor &actor, long now, int milis_per_column) const;
+
+private:
+    int columns;
+    std::vector<std::deque<Bullet*>> bullets;
+};
+
+
+#endif //SPACE_INVADERS_DANGER_MAP_H
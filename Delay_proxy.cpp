@@ -0,0 +1,126 @@
+//
+// Created by piotrek on 17.06.17.
+//
+
+#include <algorithm>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "Delay_proxy.h"
+#include "Net_channel.h"
+
+/**
+ * @param _path the path of the socket to listen on
+ * @param _server_path the path of the server's socket
+ * @param _min_delay the shortest delay in milliseconds
+ * @param _max_delay the longest delay in milliseconds
+ */
+Delay_proxy::Delay_proxy(const char* _path, const char* _server_path, int _min_delay, int _max_delay) {
+    path = _path;
+    server_path = _server_path;
+    min_delay = _min_delay;
+    max_delay = std::max(_min_delay, _max_delay);
+}
+
+/**
+ * Passes the connections on until all of them are closed
+ * @return the exit code of the program
+ */
+int Delay_proxy::run() {
+    int sock = Net_channel::listen(path);
+    if (sock < 0) {
+        std::cerr << "Can't listen on " << path << std::endl;
+        return 1;
+    }
+    bool connected = false;
+    while (!connected || !pipes.empty()) {
+        Time now = std::chrono::steady_clock::now();
+        long wait = 100;
+        std::vector<pollfd> fds;
+        fds.push_back({ sock, POLLIN, 0 });
+        for (Pipe &pipe : pipes) {
+            if (pipe.from >= 0) {
+                fds.push_back({ pipe.from, POLLIN, 0 });
+            }
+            if (!pipe.packets.empty()) {
+                wait = std::min(wait, (long) std::chrono::duration_cast<std::chrono::milliseconds>(
+                        pipe.packets.front().due - now).count());
+            }
+        }
+        poll(fds.data(), fds.size(), int(std::max(0l, wait)));
+        now = std::chrono::steady_clock::now();
+        for (unsigned long i = 1; i < fds.size(); i++) {
+            for (Pipe &pipe : pipes) {
+                if (pipe.from == fds[i].fd) pipe.events = fds[i].revents;
+            }
+        }
+
+        for (Pipe &pipe : pipes) {
+            if (pipe.from >= 0 && (pipe.events & (POLLIN | POLLHUP))) {
+                forward(pipe, now);
+            }
+            pipe.events = 0;
+            deliver(pipe, now);
+        }
+        /// The pipes come in pairs, a connection is closed when both directions have been flushed
+        for (unsigned long i = 0; i < pipes.size();) {
+            if (pipes[i].from < 0 && pipes[i].packets.empty() && pipes[i + 1].from < 0 && pipes[i + 1].packets.empty()) {
+                close(pipes[i].to);
+                close(pipes[i + 1].to);
+                pipes.erase(pipes.begin() + i, pipes.begin() + i + 2);
+            } else {
+                i += 2;
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int client = accept(sock, nullptr, nullptr);
+            int server = client >= 0 ? Net_channel::connect(server_path) : -1;
+            if (server >= 0) {
+                pipes.push_back({ client, server, std::deque<Packet>(), 0 });
+                pipes.push_back({ server, client, std::deque<Packet>(), 0 });
+                connected = true;
+            } else if (client >= 0) {
+                close(client);
+            }
+        }
+    }
+    close(sock);
+    unlink(path);
+    return 0;
+}
+
+/**
+ * Reads what has arrived and holds it, behind the bytes already held.
+ * When the sending side has closed, the other side is told once the held bytes are sent.
+ */
+void Delay_proxy::forward(Pipe &pipe, Time now) {
+    char bytes[4096];
+    ssize_t count = recv(pipe.from, bytes, sizeof(bytes), MSG_DONTWAIT);
+    if (count <= 0) {
+        shutdown(pipe.from, SHUT_RD);
+        pipe.from = -1;
+        return;
+    }
+    std::uniform_int_distribution<int> delay(min_delay, max_delay);
+    Time due = now + std::chrono::milliseconds(delay(generator));
+    if (!pipe.packets.empty()) {
+        due = std::max(due, pipe.packets.back().due);
+    }
+    pipe.packets.push_back({ due, std::vector<char>(bytes, bytes + count) });
+}
+
+/**
+ * Sends on the bytes whose delay has passed
+ */
+void Delay_proxy::deliver(Pipe &pipe, Time now) {
+    while (!pipe.packets.empty() && pipe.packets.front().due <= now) {
+        const std::vector<char> &bytes = pipe.packets.front().bytes;
+        send(pipe.to, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+        pipe.packets.pop_front();
+    }
+    if (pipe.from < 0 && pipe.packets.empty()) {
+        shutdown(pipe.to, SHUT_WR);
+    }
+}
@@ -0,0 +1,53 @@
+//
+// Created by piotrek on 17.06.17.
+//
+
+#ifndef SPACE_INVADERS_DELAY_PROXY_H
+#define SPACE_INVADERS_DELAY_PROXY_H
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include <vector>
+
+/**
+ * A socket in the middle, for trying the co-op game on a slow network. Every client connecting
+ * to the proxy gets its own connection to the server, and the bytes going either way are held
+ * for a random delay. The delays never reorder the bytes of a connection.
+ */
+class Delay_proxy {
+public:
+    Delay_proxy(const char* _path, const char* _server_path, int _min_delay, int _max_delay);
+
+    int run();
+
+private:
+    typedef std::chrono::steady_clock::time_point Time;
+
+    struct Packet {
+        Time due;
+        std::vector<char> bytes;
+    };
+
+    /// One direction of a connection, from is -1 once it has been closed
+    struct Pipe {
+        int from;
+        int to;
+        std::deque<Packet> packets;
+        short events;
+    };
+
+    const char* path;
+    const char* server_path;
+    int min_delay;
+    int max_delay;
+    std::default_random_engine generator;
+    std::vector<Pipe> pipes;
+
+    void forward(Pipe &pipe, Time now);
+
+    void deliver(Pipe &pipe, Time now);
+};
+
+
+#endif //SPACE_INVADERS_DELAY_PROXY_H
@@ -0,0 +1,111 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <algorithm>
+#include <ncurses.h>
+#include "Density_grid.h"
+
+/// The glyphs of the crowded cells, from 2-3 actors up to 64 and more
+static const char crowd_glyphs[] = ":+*#%@";
+static const int crowd_levels = sizeof(crowd_glyphs) - 1;
+
+Density_grid::Density_grid() {
+    width = 0;
+    height = 0;
+}
+
+/**
+ * Empties the grid and gives it a new size
+ * @param _width the number of columns
+ * @param _height the number of rows
+ */
+void Density_grid::reset(int _width, int _height) {
+    width = _width;
+    height = _height;
+    counts.assign((unsigned long) (width * height), 0);
+    characters.assign((unsigned long) (width * height), 0);
+}
+
+/**
+ * Adds the actor's shape to the grid or takes it away. Blank cells of the shape are skipped,
+ * as the actor doesn't cover them on the screen either.
+ * @param x the column of the actor's left edge in the grid
+ * @param y the row of the actor's top edge in the grid
+ * @param actor the actor
+ * @param change 1 to add the actor, -1 to take it away
+ */
+void Density_grid::stamp(int x, int y, const Game_actor &actor, int change) {
+    for (int row = 0; row < actor.getHeight(); row++) {
+        if (y + row < 0 || y + row >= height) continue;
+        for (int column = 0; column < actor.getWidth(); column++) {
+            if (x + column < 0 || x + column >= width) continue;
+            char character = actor.glyphAt(column, row);
+            if (character == ' ') continue;
+            unsigned long cell = (unsigned long) ((y + row) * width + x + column);
+            counts[cell] += change;
+            characters[cell] ^= character;
+        }
+    }
+}
+
+/**
+ * Draws the part of the grid inside the viewport, one pass over the visible cells.
+ * Empty cells are left untouched, the runs of covered cells are written at once.
+ * @param view the viewport
+ * @param origin_x the column of the grid's left edge in the world
+ * @param origin_y the row of the grid's top edge in the world
+ */
+void Density_grid::draw(const Viewport &view, int origin_x, int origin_y) const {
+    int first_x = std::max(0, view.getOrigin_x() - origin_x);
+    int last_x = std::min(width, view.getOrigin_x() + view.getColumns() - origin_x);
+    int first_y = std::max(0, view.getOrigin_y() - origin_y);
+    int last_y = std::min(height, view.getOrigin_y() + view.getRows() - origin_y);
+    if (first_x >= last_x) return;
+    std::vector<char> run((unsigned long) (last_x - first_x));
+    for (int y = first_y; y < last_y; y++) {
+        int length = 0;
+        int start = first_x;
+        for (int x = first_x; x <= last_x; x++) {
+            unsigned long cell = (unsigned long) (y * width + x);
+            if (x < last_x && counts[cell] > 0) {
+                if (length == 0) start = x;
+                run[length++] = glyph(counts[cell], characters[cell]);
+            } else if (length > 0) {
+                mvaddnstr(origin_y + y - view.getOrigin_y(), origin_x + start - view.getOrigin_x(), run.data(), length);
+                length = 0;
+            }
+        }
+    }
+}
+
+/**
+ * Checks if no actor covers any cell of the rectangle
+ * @param x the rectangle's left column
+ * @param y the rectangle's top row
+ * @param columns the rectangle's width
+ * @param rows the rectangle's height
+ */
+bool Density_grid::isEmpty(int x, int y, int columns, int rows) const {
+    for (int row = y; row < y + rows; row++) {
+        for (int column = x; column < x + columns; column++) {
+            if (counts[(unsigned long) (row * width + column)] > 0) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * The glyph of a cell
+ * @param count how many actors cover the cell
+ * @param single the character shown when the cell is covered by one actor
+ */
+char Density_grid::glyph(unsigned count, char single) {
+    if (count <= 1) return single;
+    int level = 0;
+    while (count > 3 && level < crowd_levels - 1) {
+        count >>= 1;
+        level++;
+    }
+    return crowd_glyphs[level];
+}
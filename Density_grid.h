@@ -0,0 +1,45 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_DENSITY_GRID_H
+#define SPACE_INVADERS_DENSITY_GRID_H
+
+#include <vector>
+#include <cstdint>
+#include "Game_actor.h"
+#include "Viewport.h"
+
+/**
+ * How many actors cover every cell of an area, for drawing crowds which don't fit the screen.
+ * A cell covered once shows the actor's own character, a crowded cell shows a glyph getting
+ * denser with every doubling of the crowd. The characters are kept xor-ed together, so when
+ * only one actor is left in a cell its character is known again without visiting the others.
+ */
+class Density_grid {
+public:
+    Density_grid();
+
+    void reset(int _width, int _height);
+
+    void stamp(int x, int y, const Game_actor &actor, int change);
+
+    void draw(const Viewport &view, int origin_x, int origin_y) const;
+
+    bool isEmpty(int x, int y, int columns, int rows) const;
+
+    int getWidth() const { return width; }
+
+    int getHeight() const { return height; }
+
+    static char glyph(unsigned count, char single);
+
+private:
+    int width;
+    int height;
+    std::vector<uint32_t> counts;
+    std::vector<char> characters; // xor of the characters of the actors covering the cell
+};
+
+
+#endif //SPACE_INVADERS_DENSITY_GRID_H
@@ -15,29 +15,36 @@ Enemy_big_slow::Enemy_big_slow(int _pos_x, int _pos_y, int _min_x, int _max_x, i
  * |_______|
  *    |||
  */
-void Enemy_big_slow::drawActor() {
+void Enemy_big_slow::drawActor(const Viewport &view) {
+    int x = pos_x - view.getOrigin_x();
+    int y = pos_y - view.getOrigin_y();
     //first pos_y
-    mvprintw(pos_y, pos_x, "$");
-    mvprintw(pos_y, pos_x+1, "_");
-    mvprintw(pos_y, pos_x+2, "_");
-    mvprintw(pos_y, pos_x+3, "_");
-    mvprintw(pos_y, pos_x+4, "_");
-    mvprintw(pos_y, pos_x+5, "_");
-    mvprintw(pos_y, pos_x+6, "_");
-    mvprintw(pos_y, pos_x+7, "_");
-    mvprintw(pos_y, pos_x+8, "$");
+    mvprintw(y, x, "$");
+    mvprintw(y, x+1, "_");
+    mvprintw(y, x+2, "_");
+    mvprintw(y, x+3, "_");
+    mvprintw(y, x+4, "_");
+    mvprintw(y, x+5, "_");
+    mvprintw(y, x+6, "_");
+    mvprintw(y, x+7, "_");
+    mvprintw(y, x+8, "$");
     //second pos_y
-    mvprintw(pos_y+1, pos_x, "|");
-    mvprintw(pos_y+1, pos_x+1, "_");
-    mvprintw(pos_y+1, pos_x+2, "_");
-    mvprintw(pos_y+1, pos_x+3, "_");
-    mvprintw(pos_y+1, pos_x+4, "_");
-    mvprintw(pos_y+1, pos_x+5, "_");
-    mvprintw(pos_y+1, pos_x+6, "_");
-    mvprintw(pos_y+1, pos_x+7, "_");
-    mvprintw(pos_y+1, pos_x+8, "|");
+    mvprintw(y+1, x, "|");
+    mvprintw(y+1, x+1, "_");
+    mvprintw(y+1, x+2, "_");
+    mvprintw(y+1, x+3, "_");
+    mvprintw(y+1, x+4, "_");
+    mvprintw(y+1, x+5, "_");
+    mvprintw(y+1, x+6, "_");
+    mvprintw(y+1, x+7, "_");
+    mvprintw(y+1, x+8, "|");
     // third pos_y
-    mvprintw(pos_y+2, pos_x+3, "|");
-    mvprintw(pos_y+2, pos_x+4, "|");
-    mvprintw(pos_y+2, pos_x+5, "|");
+    mvprintw(y+2, x+3, "|");
+    mvprintw(y+2, x+4, "|");
+    mvprintw(y+2, x+5, "|");
+}
+
+char Enemy_big_slow::glyphAt(int column, int row) const {
+    static const char* shape[] = { "$_______$", "|_______|", "   |||   " };
+    return shape[row][column];
 }
@@ -0,0 +1,85 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include "Enemy_rules.h"
+
+/**
+ * Damages the enemy with a player's hit. The hit scores a point unless the enemy is already
+ * destroyed, and the enemy is counted if the hit destroys it.
+ * @param enemy the enemy hit
+ * @param damage the damage of the hit
+ * @param big true for a big enemy, false for a small one
+ * @return true if the hit scored
+ */
+bool Enemy_rules::Tally::hit(Game_actor &enemy, int damage, bool big) {
+    if (enemy.isDone()) return false;
+    enemy.setDamage(damage);
+    points++;
+    if (enemy.isDone()) {
+        if (big) {
+            big_ships_destroyed++;
+        } else {
+            small_ships_destroyed++;
+        }
+    }
+    return true;
+}
+
+/**
+ * Destroys the enemy outright, it is counted but scores no point
+ * @param enemy the enemy
+ * @param big true for a big enemy, false for a small one
+ */
+void Enemy_rules::Tally::destroy(Game_actor &enemy, bool big) {
+    if (enemy.isDone()) return;
+    enemy.setDone();
+    if (big) {
+        big_ships_destroyed++;
+    } else {
+        small_ships_destroyed++;
+    }
+}
+
+/**
+ * @param enemy the big enemy shooting
+ * @param max_x the width of the world
+ * @param max_y the height of the world
+ * @return the bomb, under the middle of the enemy, not launched yet
+ */
+BigBullet* Enemy_rules::bigBullet(const Game_actor &enemy, int max_x, int max_y) {
+    return new BigBullet( short(enemy.getPos_x() + enemy.getWidth()/2 - 1), short(enemy.getPos_y()+1),
+                          0, max_x, 0, max_y + 3);
+}
+
+/**
+ * @param enemy the small enemy shooting
+ * @param max_x the width of the world
+ * @param max_y the height of the world
+ * @return the bullet, at the middle of the enemy, not launched yet
+ */
+SmallBullet* Enemy_rules::smallBullet(const Game_actor &enemy, int max_x, int max_y) {
+    return new SmallBullet( short(enemy.getPos_x() + enemy.getWidth()/2 ), short(enemy.getPos_y()),
+                            0, max_x, 0, max_y);
+}
+
+/**
+ * Finds the first enemy alive the player's bullet has passed on its way up from from_y.
+ * Only the members of the formations whose box the bullet has passed are checked.
+ * Reads the enemies only, so several bullets can be checked concurrently.
+ * @param bullet the player's bullet, already moved to its current row
+ * @param from_y the bullet's row before the move
+ * @param formations the formations, in the order they are checked in
+ * @return the enemy hit, nullptr if there is none
+ */
+Game_actor* Enemy_rules::firstHit(Bullet* bullet, int from_y, const std::vector<Formation*> &formations) {
+    for (Formation* formation : formations) {
+        if (formation->isDone() || !isSweptHit(bullet, from_y, formation)) continue;
+        for (Game_actor* enemy : formation->getMembers()) {
+            if (!enemy->isDone() && isSweptHit(bullet, from_y, enemy)) {
+                return enemy;
+            }
+        }
+    }
+    return nullptr;
+}
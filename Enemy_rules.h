@@ -0,0 +1,70 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_ENEMY_RULES_H
+#define SPACE_INVADERS_ENEMY_RULES_H
+
+#include <vector>
+#include "Direction.h"
+#include "Formation.h"
+#include "BigBullet.h"
+#include "SmallBullet.h"
+#include "Game_rules.h"
+
+/**
+ * The rules of the enemies, shared by the interactive game and the headless world: how a wave
+ * of them is lined up, where their bullets start, which of them a player's bullet hits
+ * and what the hits score. The engines only decide when these happen and where the actors live.
+ */
+class Enemy_rules {
+public:
+    /**
+     * The score of a game: a point for every hit of an enemy still alive,
+     * and the enemies counted once, when they are destroyed
+     */
+    struct Tally {
+        int points;
+        int big_ships_destroyed;
+        int small_ships_destroyed;
+
+        Tally() : points(0), big_ships_destroyed(0), small_ships_destroyed(0) {}
+
+        bool hit(Game_actor &enemy, int damage, bool big);
+
+        void destroy(Game_actor &enemy, bool big);
+    };
+
+    /**
+     * Lines up a wave of enemies side by side in the top row, shifted left if it doesn't fit
+     * @param x the column of the first enemy
+     * @param members the number of the enemies
+     * @param direction where the formation marches first
+     * @param max_x the width of the world
+     * @param max_y the height of the world
+     * @return the new formation, its members are the new enemies
+     */
+    template <typename Enemy>
+    static Formation* lineUp(int x, int members, Direction direction, int max_x, int max_y) {
+        Formation* formation = new Formation( 0, 0, 0, max_x, 0, max_y );
+        formation->move_direction = direction;
+        for (int i = 0; i < members; i++) {
+            Enemy* enemy = new Enemy( x, 0, 0, max_x, 0, max_y );
+            x += enemy->getWidth() + formation_spacing;
+            formation->addMember(enemy);
+        }
+        if (x > max_x) {
+            formation->move(max_x - x, 0);
+        }
+        return formation;
+    }
+
+    static BigBullet* bigBullet(const Game_actor &enemy, int max_x, int max_y);
+
+    static SmallBullet* smallBullet(const Game_actor &enemy, int max_x, int max_y);
+
+    static Game_actor* firstHit(Bullet* bullet, int from_y, const std::vector<Formation*> &formations);
+};
+
+
+#endif //SPACE_INVADERS_ENEMY_RULES_H
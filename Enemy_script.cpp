@@ -0,0 +1,131 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include "Enemy_script.h"
+#include "Formation.h"
+
+/// A script's body is a switch on its resume point. A yield stores the line it is on and returns,
+/// the next resume jumps right behind it. Locals don't survive a yield, those kept in the frame do.
+#define SCRIPT_BEGIN(frame) switch ((frame).resume_point) { case 0:
+#define SCRIPT_YIELD(frame) do { (frame).resume_point = __LINE__; return; case __LINE__:; } while (0)
+#define SCRIPT_END(frame) } (frame).resume_point = 0
+
+/**
+ * Starts the script from the beginning
+ * @param frame the script's frame
+ * @param pattern the behaviour
+ * @param turn_dice the dice result above which the formation turns at random
+ */
+void Enemy_script::start(Frame &frame, Pattern pattern, int turn_dice) {
+    frame.pattern = pattern;
+    frame.resume_point = 0;
+    frame.turn_dice = turn_dice;
+    frame.step = 0;
+    frame.steps = 0;
+}
+
+/**
+ * Runs the script until its next yield
+ * @param frame the script's frame
+ * @param formation the formation driven by the script
+ * @param host the game
+ */
+void Enemy_script::resume(Frame &frame, Formation &formation, Script_host &host) {
+    switch (frame.pattern) {
+        case MARCH:
+            march(frame, formation, host);
+            break;
+        case ZIGZAG:
+            zigzag(frame, formation, host);
+            break;
+        case DIVE:
+            dive(frame, formation, host);
+            break;
+        case STRAFE_AND_FIRE:
+            strafeAndFire(frame, formation, host);
+            break;
+    }
+}
+
+/**
+ * Goes one column, sidestepping the player's bullets, or turning when asked to
+ * @param formation the formation
+ * @param host the game
+ * @param turn true if the formation should change its route now
+ */
+void Enemy_script::step(Formation &formation, Script_host &host, bool turn) {
+    Direction way_out = host.evade(formation);
+    if (way_out != formation.move_direction) {
+        formation.move_direction = way_out;
+        turn = false;
+    }
+    host.march(formation, turn);
+}
+
+/**
+ * Marches from wall to wall, turning at random
+ */
+void Enemy_script::march(Frame &frame, Formation &formation, Script_host &host) {
+    SCRIPT_BEGIN(frame);
+    while (true) {
+        step(formation, host, host.dice() > frame.turn_dice);
+        SCRIPT_YIELD(frame);
+    }
+    SCRIPT_END(frame);
+}
+
+/**
+ * Marches a short way, goes one row down and back, over and over
+ */
+void Enemy_script::zigzag(Frame &frame, Formation &formation, Script_host &host) {
+    SCRIPT_BEGIN(frame);
+    while (true) {
+        frame.steps = 8 + host.dice() % 16;
+        for (frame.step = 0; frame.step < frame.steps; frame.step++) {
+            step(formation, host, false);
+            SCRIPT_YIELD(frame);
+        }
+        step(formation, host, true);
+        SCRIPT_YIELD(frame);
+    }
+    SCRIPT_END(frame);
+}
+
+/**
+ * Marches for a while, then swoops two rows down at once
+ */
+void Enemy_script::dive(Frame &frame, Formation &formation, Script_host &host) {
+    SCRIPT_BEGIN(frame);
+    while (true) {
+        frame.steps = 10 + host.dice() % 30;
+        for (frame.step = 0; frame.step < frame.steps; frame.step++) {
+            step(formation, host, host.dice() > frame.turn_dice);
+            SCRIPT_YIELD(frame);
+        }
+        for (frame.step = 0; frame.step < 2; frame.step++) {
+            host.descend(formation);
+            SCRIPT_YIELD(frame);
+        }
+    }
+    SCRIPT_END(frame);
+}
+
+/**
+ * Rushes sideways at double speed, then stops to shoot a volley
+ */
+void Enemy_script::strafeAndFire(Frame &frame, Formation &formation, Script_host &host) {
+    SCRIPT_BEGIN(frame);
+    while (true) {
+        frame.steps = 6 + host.dice() % 10;
+        for (frame.step = 0; frame.step < frame.steps; frame.step++) {
+            step(formation, host, false);
+            step(formation, host, false);
+            SCRIPT_YIELD(frame);
+        }
+        host.fire(formation);
+        SCRIPT_YIELD(frame);
+        SCRIPT_YIELD(frame);
+    }
+    SCRIPT_END(frame);
+}
@@ -0,0 +1,89 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_ENEMY_SCRIPT_H
+#define SPACE_INVADERS_ENEMY_SCRIPT_H
+
+#include "Direction.h"
+
+class Formation;
+
+/**
+ * The game as seen by the enemies' scripts
+ */
+class Script_host {
+public:
+    virtual ~Script_host() {}
+
+    /**
+     * @return a dice result from 1 to 100
+     */
+    virtual int dice() = 0;
+
+    /**
+     * @param formation the formation
+     * @return the direction the formation should go to dodge the player's bullets
+     */
+    virtual Direction evade(const Formation &formation) = 0;
+
+    /**
+     * Moves the formation one column, or one row down when it turns
+     * @param formation the formation
+     * @param turn true if the formation should change its route now
+     */
+    virtual void march(Formation &formation, bool turn) = 0;
+
+    /**
+     * Moves the formation one row down, unless the shields are in the way
+     * @param formation the formation
+     */
+    virtual void descend(Formation &formation) = 0;
+
+    /**
+     * Shoots a volley from the formation's members
+     * @param formation the formation
+     */
+    virtual void fire(const Formation &formation) = 0;
+};
+
+/**
+ * The enemies' behaviours, written as stackless coroutines. A script runs as if it had
+ * a formation of its own, and gives the turn back after every step of it. Everything
+ * it needs to remember across that is kept in a small frame instead of a stack, so any
+ * number of scripts can be interleaved on a single thread, each resumed once per tick.
+ */
+class Enemy_script {
+public:
+    enum Pattern { MARCH, ZIGZAG, DIVE, STRAFE_AND_FIRE };
+    static const int PATTERNS = 4;
+
+    /**
+     * The state of a script between two ticks
+     */
+    struct Frame {
+        Pattern pattern;
+        int resume_point; // where the script goes on from, 0 before its first tick
+        int turn_dice; // the dice result above which the formation turns at random
+        int step; // the locals living across the steps
+        int steps;
+    };
+
+    static void start(Frame &frame, Pattern pattern, int turn_dice);
+
+    static void resume(Frame &frame, Formation &formation, Script_host &host);
+
+private:
+    static void march(Frame &frame, Formation &formation, Script_host &host);
+
+    static void zigzag(Frame &frame, Formation &formation, Script_host &host);
+
+    static void dive(Frame &frame, Formation &formation, Script_host &host);
+
+    static void strafeAndFire(Frame &frame, Formation &formation, Script_host &host);
+
+    static void step(Formation &formation, Script_host &host, bool turn);
+};
+
+
+#endif //SPACE_INVADERS_ENEMY_SCRIPT_H
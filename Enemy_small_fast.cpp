@@ -14,10 +14,16 @@ Enemy_small_fast::Enemy_small_fast(int _pos_x, int _pos_y, int _min_x, int _max_
  *
  * $=|=$
  */
-void Enemy_small_fast::drawActor() {
-    mvprintw(pos_y, pos_x, "$");
-    mvprintw(pos_y, pos_x+1, "=");
-    mvprintw(pos_y, pos_x+2, "|");
-    mvprintw(pos_y, pos_x+3, "=");
-    mvprintw(pos_y, pos_x+4, "$");
+void Enemy_small_fast::drawActor(const Viewport &view) {
+    int x = pos_x - view.getOrigin_x();
+    int y = pos_y - view.getOrigin_y();
+    mvprintw(y, x, "$");
+    mvprintw(y, x+1, "=");
+    mvprintw(y, x+2, "|");
+    mvprintw(y, x+3, "=");
+    mvprintw(y, x+4, "$");
+}
+
+char Enemy_small_fast::glyphAt(int column, int) const {
+    return "$=|=$"[column];
 }
@@ -7,11 +7,13 @@
 
 #include <ncurses.h>
 #include "Game_actor.h"
+#include "Memory_stats.h"
 
-class Enemy_small_fast : public Game_actor {
+class Enemy_small_fast : public Game_actor, public Memory_counted<Memory_stats::ENEMY_SMALL_FAST> {
 public:
     Enemy_small_fast(int _pos_x, int _pos_y, int _min_x, int _max_x, int _min_y, int _max_y);
-    void drawActor();
+    void drawActor(const Viewport &view);
+    char glyphAt(int column, int row) const;
 };
 
 
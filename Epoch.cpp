@@ -0,0 +1,121 @@
+//
+// Created by piotrek on 18.06.17.
+//
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "Epoch.h"
+
+/// Retiring that many objects triggers a collection, which bounds the garbage of a thread
+static const int collect_every = 64;
+
+struct Retired {
+    void* object;
+    void (*destroy)(void*);
+    unsigned long epoch;
+};
+
+/**
+ * The epoch state of one thread. The guard word is the epoch seen by the thread, shifted left,
+ * with the lowest bit set while the thread holds a guard. The garbage is touched only by its thread.
+ */
+struct Epoch_thread {
+    std::atomic<unsigned long> guard;
+    int nesting;
+    int retired_since_collect;
+    std::vector<Retired> garbage;
+};
+
+static std::atomic<unsigned long> global_epoch(0);
+static std::atomic<long> pending(0);
+
+/// The threads are registered once and never removed, a finished thread holds no guard
+static std::mutex registry_mutex;
+static std::vector<Epoch_thread*> registry;
+
+static Epoch_thread* epoch_thread() {
+    thread_local Epoch_thread* state = nullptr;
+    if (state == nullptr) {
+        state = new Epoch_thread();
+        state->guard = 0;
+        state->nesting = 0;
+        state->retired_since_collect = 0;
+        registry_mutex.lock();
+        registry.push_back(state);
+        registry_mutex.unlock();
+    }
+    return state;
+}
+
+Epoch::Guard::Guard() {
+    Epoch_thread* state = epoch_thread();
+    if (state->nesting++ == 0) {
+        /// Sequentially consistent, so the guard is visible before any shared pointer is read
+        state->guard.store(global_epoch.load() << 1 | 1);
+    }
+}
+
+Epoch::Guard::~Guard() {
+    Epoch_thread* state = epoch_thread();
+    if (--state->nesting == 0) {
+        state->guard.store(0, std::memory_order_release);
+    }
+}
+
+/**
+ * Queues the object to be freed by the calling thread
+ * @param object the object
+ * @param destroy the function freeing it
+ */
+void Epoch::retire(void* object, void (*destroy)(void*)) {
+    Epoch_thread* state = epoch_thread();
+    state->garbage.push_back({ object, destroy, global_epoch.load() });
+    pending++;
+    if (++state->retired_since_collect >= collect_every) {
+        collect();
+    }
+}
+
+/**
+ * Advances the epoch if every guarded thread has seen the current one,
+ * then frees the calling thread's objects retired at least two epochs ago
+ */
+void Epoch::collect() {
+    Epoch_thread* state = epoch_thread();
+    state->retired_since_collect = 0;
+    unsigned long epoch = global_epoch.load();
+    bool seen = true;
+    registry_mutex.lock();
+    for (Epoch_thread* thread : registry) {
+        unsigned long guard = thread->guard.load();
+        if ((guard & 1) && (guard >> 1) != epoch) {
+            seen = false;
+            break;
+        }
+    }
+    registry_mutex.unlock();
+    if (seen) {
+        global_epoch.compare_exchange_strong(epoch, epoch + 1);
+    }
+
+    epoch = global_epoch.load();
+    std::vector<Retired> &garbage = state->garbage;
+    unsigned long kept = 0;
+    for (unsigned long i = 0; i < garbage.size(); i++) {
+        if (garbage[i].epoch + 2 <= epoch) {
+            garbage[i].destroy(garbage[i].object);
+            pending--;
+        } else {
+            garbage[kept++] = garbage[i];
+        }
+    }
+    garbage.resize(kept);
+}
+
+/**
+ * @return the number of the objects retired but not freed yet, in all the threads
+ */
+long Epoch::getPending() {
+    return pending.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,50 @@
+//
+// Created by piotrek on 18.06.17.
+//
+
+#ifndef SPACE_INVADERS_EPOCH_H
+#define SPACE_INVADERS_EPOCH_H
+
+/**
+ * Epoch based reclamation of the actors shared between the threads. A thread reading shared
+ * pointers without a lock holds a Guard, which only publishes the global epoch it has seen.
+ * Removed objects are retired instead of deleted: they are freed by the retiring thread
+ * two epochs later, when no guard can still hold them. The epoch advances once every
+ * guarded thread has seen the current one, so a retired object waits at most as long
+ * as the longest guard.
+ */
+class Epoch {
+public:
+    /**
+     * Pins the calling thread to the current epoch for its lifetime. Guards may be nested.
+     */
+    class Guard {
+    public:
+        Guard();
+
+        ~Guard();
+
+        Guard(const Guard &) = delete;
+
+        Guard &operator=(const Guard &) = delete;
+    };
+
+    /**
+     * Frees the object once no reader can see it anymore.
+     * It must already be unreachable for the readers starting from now.
+     * @param object the object to be freed
+     */
+    template <typename T>
+    static void retire(T* object) {
+        retire(object, [](void* retired) { delete static_cast<T*>(retired); });
+    }
+
+    static void retire(void* object, void (*destroy)(void*));
+
+    static void collect();
+
+    static long getPending();
+};
+
+
+#endif //SPACE_INVADERS_EPOCH_H
@@ -0,0 +1,270 @@
+//
+// Created by piotrek on 11.06.17.
+//
+
+#include <algorithm>
+#include "Formation.h"
+#include "Spatial_index.h"
+#include "Shield_wall.h"
+
+Formation::Formation(int _pos_x, int _pos_y, int _min_x, int _max_x, int _min_y, int _max_y)
+        : Game_actor(_pos_x, _pos_y, 0, 0, _min_x, _max_x, _min_y, _max_y) {
+    density = nullptr;
+    density_stale = true;
+    script = -1;
+}
+
+/**
+ * Copies the formation sharing the members, the copy builds its own density grid and runs no script
+ */
+Formation::Formation(const Formation &other) : Game_actor(other), members(other.members) {
+    density = nullptr;
+    density_stale = true;
+    script = -1;
+}
+
+Formation::~Formation() {
+    delete density;
+}
+
+/**
+ * Draws the members inside the viewport. Members are drawn through a viewport shifted
+ * to the formation's corner, because their own coordinates are only offsets.
+ * A crowd is drawn as the visible part of its density grid instead.
+ * @param view the viewport
+ */
+void Formation::drawActor(const Viewport &view) {
+    if (crowd(CROWD_MEMBERS) != nullptr) {
+        density->draw(view, pos_x, pos_y);
+        return;
+    }
+    Viewport local = view.shifted(-pos_x, -pos_y);
+    for (Game_actor* member : members) {
+        if (!member->isDone() && view.isVisible(member)) {
+            member->drawActor(local);
+        }
+    }
+}
+
+/**
+ * Draws the formation from its density grid whatever its size: the members' glyphs only,
+ * without their colours, a run of cells at a time
+ * @param view the viewport
+ */
+void Formation::drawCoarse(const Viewport &view) {
+    Density_grid* grid = crowd(1);
+    if (grid != nullptr) {
+        grid->draw(view, pos_x, pos_y);
+    }
+}
+
+/**
+ * Adds the actor to the formation. The actor's screen position is kept,
+ * the bounding box of the formation grows if needed.
+ * @param actor the actor to join the formation
+ */
+void Formation::addMember(Game_actor* actor) {
+    int x = actor->getPos_x();
+    int y = actor->getPos_y();
+    if (members.empty()) {
+        pos_x = x;
+        pos_y = y;
+    }
+    actor->pos_x = x - pos_x;
+    actor->pos_y = y - pos_y;
+    actor->formation = this;
+    members.push_back(actor);
+    if (members.size() == 1 || actor->pos_x < 0 || actor->pos_y < 0) {
+        rebound();
+        return;
+    }
+    /// A member right of or below the corner can only stretch the box, the others keep their offsets
+    int right = std::max(width, actor->pos_x + actor->width);
+    int bottom = std::max(height, actor->pos_y + actor->height);
+    if (right != width || bottom != height) {
+        width = right;
+        height = bottom;
+        density_stale = true;
+        if (index != nullptr) {
+            index->relocate(this);
+        }
+    } else {
+        stamp(actor, 1);
+    }
+}
+
+/**
+ * Removes the actor from the formation, giving it back its screen coordinates.
+ * The formation is done when the last member leaves.
+ * @param actor the actor to leave the formation
+ */
+void Formation::removeMember(Game_actor* actor) {
+    std::vector<Game_actor*>::iterator it = std::find(members.begin(), members.end(), actor);
+    if (it == members.end()) return;
+    stamp(actor, -1);
+    members.erase(it);
+    /// Only a member touching the edge of the box can make it smaller,
+    /// and not while a crowd still covers that edge
+    bool edge = actor->pos_x == 0 || actor->pos_y == 0
+                || actor->pos_x + actor->width == width || actor->pos_y + actor->height == height;
+    Density_grid* grid = crowd(CROWD_MEMBERS);
+    if (edge && grid != nullptr) {
+        edge = (actor->pos_x == 0 && grid->isEmpty(0, 0, 1, height))
+               || (actor->pos_y == 0 && grid->isEmpty(0, 0, width, 1))
+               || (actor->pos_x + actor->width == width && grid->isEmpty(width - 1, 0, 1, height))
+               || (actor->pos_y + actor->height == height && grid->isEmpty(0, height - 1, width, 1));
+    }
+    actor->pos_x += pos_x;
+    actor->pos_y += pos_y;
+    actor->formation = nullptr;
+    if (members.empty()) {
+        done = true;
+        width = 0;
+        height = 0;
+    } else if (edge) {
+        rebound();
+    }
+}
+
+/**
+ * Moves a member out to its own single member formation, going the opposite way.
+ * @param member the index of the member
+ * @return the new formation, or nullptr if the formation has only one member
+ */
+Formation* Formation::breakFormation(int member) {
+    if (members.size() < 2) return nullptr;
+    Game_actor* actor = members[member % members.size()];
+    removeMember(actor);
+    Formation* single = new Formation(actor->pos_x, actor->pos_y, min_x, max_x, min_y, max_y);
+    single->move_direction = move_direction == RIGHT ? LEFT : RIGHT;
+    single->addMember(actor);
+    return single;
+}
+
+/**
+ * Moves the formation one column. The formations go from left to right, or right to left.
+ * When they reach the wall, they go down one row. They can also change the route unexpectedly
+ * and go down one row. Only the formation's corner changes, its members are not touched.
+ * @param turn true if the formation should change its route now
+ * @param shields the shields the formation can't go through
+ * @return true if the formation has reached the bottom of the screen
+ */
+bool Formation::march(bool turn, const Shield_wall &shields) {
+    if (turn) {
+        move_direction = move_direction == RIGHT ? LEFT : RIGHT;
+        if (lower() && shields.overlaps(this)) {
+            move(0, -1);
+        }
+    }
+    if (move_direction == RIGHT) {
+        if (pos_x + width < max_x) {
+            move(1, 0);
+            if (shields.overlaps(this)) {
+                move_direction = LEFT;
+                move(-2, 0);
+            }
+        } else {
+            lower();
+            move_direction = LEFT;
+        }
+    } else {
+        if (pos_x > min_x) {
+            move(-1, 0);
+            if (shields.overlaps(this)) {
+                move_direction = RIGHT;
+                move(2, 0);
+            }
+        } else {
+            lower();
+            move_direction = RIGHT;
+        }
+    }
+    return pos_y + height == max_y;
+}
+
+/**
+ * Moves the formation one row down, unless the shields are in the way
+ * @param shields the shields the formation can't go through
+ * @return true if the formation has reached the bottom of the screen
+ */
+bool Formation::descend(const Shield_wall &shields) {
+    if (lower() && shields.overlaps(this)) {
+        move(0, -1);
+    }
+    return pos_y + height == max_y;
+}
+
+/**
+ * Moves the formation one row down, unless it is in the bottom row already. A step of a script
+ * may go down twice, and going past the bottom would end the formation with its members in it.
+ * @return true if the formation has moved
+ */
+bool Formation::lower() {
+    if (pos_y + height >= max_y) return false;
+    move(0, 1);
+    return true;
+}
+
+/**
+ * Recomputes the cached bounding box, so its top left corner is the formation's position
+ * and every offset is non negative.
+ */
+void Formation::rebound() {
+    int left = members[0]->pos_x;
+    int top = members[0]->pos_y;
+    int right = left + members[0]->width;
+    int bottom = top + members[0]->height;
+    for (Game_actor* member : members) {
+        left = std::min(left, member->pos_x);
+        top = std::min(top, member->pos_y);
+        right = std::max(right, member->pos_x + member->width);
+        bottom = std::max(bottom, member->pos_y + member->height);
+    }
+    if (left != 0 || top != 0) {
+        for (Game_actor* member : members) {
+            member->pos_x -= left;
+            member->pos_y -= top;
+        }
+        pos_x += left;
+        pos_y += top;
+    }
+    if (left != 0 || top != 0 || width != right - left || height != bottom - top) {
+        density_stale = true;
+    }
+    width = right - left;
+    height = bottom - top;
+    if (index != nullptr) {
+        index->relocate(this);
+    }
+}
+
+/**
+ * The density grid of a crowd, built again if the members have moved inside the box
+ * @param fewest the fewest members drawn from the grid
+ * @return the grid, or nullptr when the formation is too small
+ */
+Density_grid* Formation::crowd(unsigned long fewest) {
+    if (members.size() < fewest) return nullptr;
+    if (density == nullptr) {
+        density = new Density_grid();
+    }
+    if (density_stale) {
+        density->reset(width, height);
+        density_stale = false;
+        for (Game_actor* member : members) {
+            stamp(member, 1);
+        }
+    }
+    return density;
+}
+
+/**
+ * Adds a member to the density grid or takes it away, unless the grid is to be built again anyway
+ * @param member the member
+ * @param change 1 to add the member, -1 to take it away
+ */
+void Formation::stamp(Game_actor* member, int change) {
+    if (density != nullptr && !density_stale) {
+        density->stamp(member->pos_x, member->pos_y, *member, change);
+    }
+}
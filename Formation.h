@@ -0,0 +1,87 @@
+//
+// Created by piotrek on 11.06.17.
+//
+
+#ifndef SPACE_INVADERS_FORMATION_H
+#define SPACE_INVADERS_FORMATION_H
+
+#include <vector>
+#include "Game_actor.h"
+#include "Density_grid.h"
+#include "Memory_stats.h"
+
+class Shield_wall;
+
+/**
+ * A group of enemies moving together. The formation itself is an actor covering the cached
+ * bounding box of its members, and the members keep only their offsets from its top left corner,
+ * so moving the whole group is a single move of the formation. Members are touched only when
+ * they join, die or break the formation. A crowd is drawn from a density grid of its box,
+ * kept up to date as the members come and go, so drawing it costs no more than the visible
+ * part of the box, however many members there are.
+ */
+class Formation : public Game_actor, public Memory_counted<Memory_stats::FORMATION> {
+    std::vector<Game_actor*> members;
+    Density_grid* density; // built when first drawn as a crowd
+    bool density_stale; // the members have moved inside the box, the grid must be built again
+    int script; // the frame of the script driving the formation, -1 when there is none
+
+    void rebound();
+
+    bool lower();
+
+    void stamp(Game_actor* member, int change);
+
+    Density_grid* crowd(unsigned long fewest);
+
+public:
+    static const unsigned long CROWD_MEMBERS = 64; // formations at least that big are drawn as crowds
+
+    Formation(int _pos_x, int _pos_y, int _min_x, int _max_x, int _min_y, int _max_y);
+
+    Formation(const Formation &other);
+
+    ~Formation();
+
+    Formation &operator=(const Formation &) = delete;
+
+    void drawActor(const Viewport &view);
+
+    void drawCoarse(const Viewport &view);
+
+    void addMember(Game_actor* actor);
+
+    void removeMember(Game_actor* actor);
+
+    Formation* breakFormation(int member);
+
+    bool march(bool turn, const Shield_wall &shields);
+
+    bool descend(const Shield_wall &shields);
+
+    unsigned long size() const { return members.size(); }
+
+    const std::vector<Game_actor*> &getMembers() const { return members; }
+
+    int getScript() const { return script; }
+
+    void setScript(int _script) { script = _script; }
+
+    /**
+     * Copies the formation together with its members
+     * @param copyMember the function returning the copy of a member
+     * @return the copy
+     */
+    template <typename F>
+    Formation* copy(F copyMember) const {
+        Formation* formation = new Formation(*this);
+        for (Game_actor* &member : formation->members) {
+            member = copyMember(member);
+            member->formation = formation;
+        }
+        return formation;
+    }
+};
+
+
+#endif //SPACE_INVADERS_FORMATION_H
@@ -0,0 +1,62 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <cstdio>
+#include "Frame_governor.h"
+#include "Trace.h"
+
+static const char* level_names[] = { "full", "slow HUD", "no effects", "coarse distant enemies" };
+
+/**
+ * @param _budget the time of a frame
+ */
+Frame_governor::Frame_governor(std::chrono::nanoseconds _budget)
+        : budget((long) _budget.count()), level(FULL), frames(0), last_change(0), calm(0), overruns(0) {}
+
+/**
+ * Takes the frame's work into account, changing the level when needed. Called once per frame.
+ * @param tick the time of the frame, in milliseconds since the start of the game
+ * @param work how long the frame's work took, without waiting for the next frame
+ */
+void Frame_governor::measure(long tick, std::chrono::nanoseconds work) {
+    long nanos = (long) work.count();
+    frames++;
+    if (nanos > budget) {
+        overruns++;
+        calm = 0;
+        if (level < COARSE_DISTANT && frames - last_change >= COOLDOWN_FRAMES) {
+            change(tick, Level(level + 1), nanos);
+        }
+    } else if (nanos < budget / 2) {
+        calm++;
+        if (calm >= CALM_FRAMES && level > FULL) {
+            change(tick, Level(level - 1), nanos);
+            calm = 0;
+        }
+    } else {
+        calm = 0;
+    }
+}
+
+/**
+ * Prints the number of the overruns and every change of the level
+ * @param out the stream
+ */
+void Frame_governor::printLog(std::ostream &out) const {
+    out << "governor: " << frames << " frames, " << overruns << " over the budget, "
+        << log.size() << " changes, ended at " << level_names[level] << std::endl;
+    for (const Change &logged : log) {
+        char line[128];
+        std::snprintf(line, sizeof(line), "governor: %8.3f s  %s -> %s  (frame of %.1f ms)",
+                      logged.tick / 1000.0, level_names[logged.from], level_names[logged.to], logged.work / 1e6);
+        out << line << std::endl;
+    }
+}
+
+void Frame_governor::change(long tick, Level to, long work) {
+    log.push_back({ tick, level, to, work });
+    Trace::instant(to > level ? "governor degrades" : "governor restores");
+    level = to;
+    last_change = frames;
+}
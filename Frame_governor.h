@@ -0,0 +1,57 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_FRAME_GOVERNOR_H
+#define SPACE_INVADERS_FRAME_GOVERNOR_H
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+/**
+ * Keeps the frames within their budget under load. Every frame's work is measured against
+ * the budget; an overrun sheds one more level of cosmetic work, in a fixed order, and a level
+ * is restored once the frames have had plenty of headroom for a while. Only drawing is ever
+ * shed, the game's logic runs in full whatever the level. Every change is logged.
+ */
+class Frame_governor {
+public:
+    /// The levels of shed work, each one including those before it
+    enum Level { FULL, SLOW_HUD, NO_EFFECTS, COARSE_DISTANT };
+
+    static const int HUD_FRAMES = 5; // a slowed HUD is printed once per that many frames
+    static const int COOLDOWN_FRAMES = 5; // frames between two degradations, for the last one to take effect
+    static const int CALM_FRAMES = 50; // frames using less than half of the budget before a level is restored
+
+    explicit Frame_governor(std::chrono::nanoseconds _budget);
+
+    void measure(long tick, std::chrono::nanoseconds work);
+
+    bool sheds(Level shed) const { return level >= shed; }
+
+    bool refreshesHud() const { return level < SLOW_HUD || frames % HUD_FRAMES == 0; }
+
+    void printLog(std::ostream &out) const;
+
+private:
+    struct Change {
+        long tick; // when the level changed, in milliseconds since the start of the game
+        Level from;
+        Level to;
+        long work; // the work of the frame which caused the change, in nanoseconds
+    };
+
+    long budget; // nanoseconds
+    Level level;
+    long frames;
+    long last_change; // the frame of the last change
+    int calm; // consecutive frames with plenty of headroom
+    long overruns;
+    std::vector<Change> log;
+
+    void change(long tick, Level to, long work);
+};
+
+
+#endif //SPACE_INVADERS_FRAME_GOVERNOR_H
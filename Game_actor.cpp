@@ -1,7 +1,10 @@
 //
 // Created by piotrek on 04.06.17.
 //
+#include <algorithm>
 #include "Game_actor.h"
+#include "Spatial_index.h"
+#include "Formation.h"
 
 /**
  * Constructs the abstarct game actor
@@ -26,6 +29,11 @@ Game_actor::Game_actor(int _pos_x, int _pos_y, int _width, int _height, int _min
     max_x = _max_x;
     min_y = _min_y;
     max_y = _max_y;
+    done = false;
+    hit_points = 0;
+    index = nullptr;
+    index_bucket = -1;
+    formation = nullptr;
 }
 
 /**
@@ -60,6 +68,9 @@ void Game_actor::move(int move_x, int move_y) {
             }
             pos_y += move_y;
         }
+        if (index != nullptr) {
+            index->relocate(this);
+        }
     }
 }
 
@@ -80,11 +91,11 @@ int Game_actor::getMin_y() const {
 }
 
 int Game_actor::getPos_x() const {
-    return pos_x;
+    return formation != nullptr ? formation->getPos_x() + pos_x : pos_x;
 }
 
 int Game_actor::getPos_y() const {
-    return pos_y;
+    return formation != nullptr ? formation->getPos_y() + pos_y : pos_y;
 }
 
 int Game_actor::getHit_points() const {
@@ -99,4 +110,41 @@ void Game_actor::setDamage(int hp) {
     }
 }
 
+bool isHit(Game_actor* bullet, Game_actor* actor) {
+    int bullet_x = bullet->getPos_x();
+    int bullet_y = bullet->getPos_y();
+    int bullet_w = bullet->getWidth();
+    int bullet_h = bullet->getHeight();
+    int actor_x_min = actor->getPos_x();
+    int actor_x_max = actor_x_min + actor->getWidth();
+    int actor_y_min = actor->getPos_y();
+    int actor_y_max = actor_y_min + actor->getHeight();
+
+    actor_x_min -= bullet_w;
+    actor_y_min -= bullet_h;
+
+    return bullet_x > actor_x_min
+           && bullet_x < actor_x_max
+            && bullet_y > actor_y_min
+            && bullet_y < actor_y_max;
+}
+
+/**
+ * Checks if the bullet hit the actor anywhere on its way from the row from_y to its current row,
+ * so fast bullets can't jump over thin targets between two frames.
+ * @param bullet the bullet
+ * @param from_y the bullet's top row in the previous check
+ * @param actor the actor
+ */
+bool isSweptHit(Game_actor* bullet, int from_y, Game_actor* actor) {
+    int bullet_x = bullet->getPos_x();
+    int top = std::min(from_y, bullet->getPos_y());
+    int bottom = std::max(from_y, bullet->getPos_y()) + bullet->getHeight();
+    int actor_x = actor->getPos_x();
+    int actor_y = actor->getPos_y();
 
+    return bullet_x + bullet->getWidth() > actor_x
+           && bullet_x < actor_x + actor->getWidth()
+           && bottom > actor_y
+           && top < actor_y + actor->getHeight();
+}
@@ -6,7 +6,15 @@
 #define SPACE_INVADERS_GAME_ACTOR_H
 
 #include "Direction.h"
+#include "Viewport.h"
+
+class Spatial_index;
+class Formation;
+
 class Game_actor {
+    friend class Spatial_index;
+    friend class Formation;
+
 protected:
     int pos_x;
     int pos_y;
@@ -18,19 +26,32 @@ protected:
     int height;
     bool done;
     int hit_points;
+    Spatial_index* index;
+    int index_bucket;
+    /// When the actor is a member of a formation, pos_x and pos_y are offsets from its corner
+    Formation* formation;
 
 public:
     Direction move_direction = RIGHT;
 
-    virtual void drawActor() = 0;
+    virtual ~Game_actor() {}
+
+    virtual void drawActor(const Viewport &view) = 0;
+
+    /**
+     * The character the actor's shape shows in the given cell, for drawing the actor without ncurses
+     * @param column the column inside the shape
+     * @param row the row inside the shape
+     */
+    virtual char glyphAt(int, int) const { return '#'; }
 
     Game_actor(int _pos_x, int _pos_y, int _width, int _height, int _min_x, int _max_x, int _min_y, int _max_y);
 
     void move(int move_x, int move_y);
 
-    int getWidth() { return width; }
+    int getWidth() const { return width; }
 
-    int getHeight() { return height; }
+    int getHeight() const { return height; }
 
     int getPos_x() const;
 
@@ -44,6 +65,8 @@ public:
 
     int getMin_y() const;
 
+    Formation* getFormation() const { return formation; }
+
     void setDone() { done = true; }
     bool isDone() { return  done; }
 
@@ -52,5 +75,9 @@ public:
     void setDamage(int hp);
 };
 
+bool isHit(Game_actor* bullet, Game_actor* actor);
+
+bool isSweptHit(Game_actor* bullet, int from_y, Game_actor* actor);
+
 #endif //SPACE_INVADERS_GAME_ACTOR_H
 
@@ -0,0 +1,181 @@
+//
+// Created by piotrek on 14.06.17.
+//
+
+#ifdef SPACE_INVADERS_LOCK_STATS
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <string>
+#include <algorithm>
+#include "Game_mutex.h"
+
+static const int sites_per_thread = 128;
+
+/**
+ * Counters of one call site in one thread. Only the owning thread writes them,
+ * the atomics just let the report read them while the game is running.
+ */
+struct Site_counters {
+    std::atomic<const char*> mutex_name;
+    std::atomic<const char*> file;
+    std::atomic<int> line;
+    std::atomic<uint64_t> acquires;
+    std::atomic<uint64_t> wait_total;
+    std::atomic<uint64_t> wait_max;
+    std::atomic<uint64_t> hold_total;
+    std::atomic<uint64_t> hold_max;
+};
+
+struct Thread_counters {
+    Site_counters sites[sites_per_thread];
+};
+
+/// Tables of all the threads, registered once per thread and never freed,
+/// so the report can include the threads which have already finished
+static std::mutex registry_mutex;
+static std::vector<Thread_counters*> registry;
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static Thread_counters* thread_counters() {
+    thread_local Thread_counters* counters = nullptr;
+    if (counters == nullptr) {
+        counters = new Thread_counters();
+        for (Site_counters &site : counters->sites) {
+            site.mutex_name = nullptr;
+            site.file = nullptr;
+            site.line = 0;
+            site.acquires = 0;
+            site.wait_total = 0;
+            site.wait_max = 0;
+            site.hold_total = 0;
+            site.hold_max = 0;
+        }
+        registry_mutex.lock();
+        registry.push_back(counters);
+        registry_mutex.unlock();
+    }
+    return counters;
+}
+
+/**
+ * Finds the counters of the call site in the calling thread's table, by open addressing
+ * on the addresses of the mutex name and the file name, and the line number.
+ */
+static Site_counters* site_counters(const char* mutex_name, const char* file, int line) {
+    Thread_counters* counters = thread_counters();
+    uintptr_t hash = (uintptr_t(mutex_name) >> 3) * 31 + (uintptr_t(file) >> 3) * 17 + uintptr_t(line);
+    for (int probe = 0; probe < sites_per_thread; probe++) {
+        Site_counters &site = counters->sites[(hash + probe) % sites_per_thread];
+        int site_line = site.line.load(std::memory_order_acquire);
+        if (site_line == 0) {
+            site.mutex_name.store(mutex_name, std::memory_order_relaxed);
+            site.file.store(file, std::memory_order_relaxed);
+            site.line.store(line, std::memory_order_release);
+            return &site;
+        }
+        if (site_line == line && site.file.load(std::memory_order_relaxed) == file
+            && site.mutex_name.load(std::memory_order_relaxed) == mutex_name) {
+            return &site;
+        }
+    }
+    /// The table is full, the last slot collects everything else
+    return &counters->sites[sites_per_thread - 1];
+}
+
+static void add(std::atomic<uint64_t> &total, std::atomic<uint64_t> &max, uint64_t value) {
+    total.store(total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    if (value > max.load(std::memory_order_relaxed)) {
+        max.store(value, std::memory_order_relaxed);
+    }
+}
+
+void Game_mutex::lock(const char* file, int line) {
+    int64_t asked = Trace::isEnabled() ? Trace::clock() : -1;
+    int64_t start = now_ns();
+    mutex.lock();
+    int64_t acquired = now_ns();
+    traced(asked);
+    Site_counters* site = site_counters(name, file, line);
+    site->acquires.store(site->acquires.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    add(site->wait_total, site->wait_max, uint64_t(acquired - start));
+    holder_site = site;
+    acquired_at = acquired;
+}
+
+void Game_mutex::unlock() {
+    Site_counters* site = holder_site;
+    uint64_t held = uint64_t(now_ns() - acquired_at);
+    int64_t since = traced_since;
+    int64_t wait = traced_wait;
+    mutex.unlock();
+    add(site->hold_total, site->hold_max, held);
+    if (since >= 0) {
+        Trace::slice(name, "lock", since, wait);
+    }
+}
+
+/**
+ * Prints the counters of every call site summed over all the threads,
+ * followed by the sites with the worst waits and the longest critical sections.
+ * @param out the stream
+ * @param top how many sites to show in the rankings
+ */
+void Game_mutex::report(std::ostream &out, int top) {
+    struct Totals {
+        std::string site;
+        uint64_t acquires, wait_total, wait_max, hold_total, hold_max;
+    };
+    std::map<std::tuple<std::string, std::string, int>, Totals> sites;
+    registry_mutex.lock();
+    for (Thread_counters* counters : registry) {
+        for (Site_counters &site : counters->sites) {
+            int line = site.line.load(std::memory_order_acquire);
+            if (line == 0) continue;
+            std::string mutex_name = site.mutex_name.load(std::memory_order_relaxed);
+            std::string file = site.file.load(std::memory_order_relaxed);
+            Totals &totals = sites[std::make_tuple(mutex_name, file, line)];
+            if (totals.site.empty()) {
+                totals = { mutex_name + " @ " + file.substr(file.find_last_of('/') + 1) + ":" + std::to_string(line),
+                           0, 0, 0, 0, 0 };
+            }
+            totals.acquires += site.acquires.load(std::memory_order_relaxed);
+            totals.wait_total += site.wait_total.load(std::memory_order_relaxed);
+            totals.wait_max = std::max(totals.wait_max, site.wait_max.load(std::memory_order_relaxed));
+            totals.hold_total += site.hold_total.load(std::memory_order_relaxed);
+            totals.hold_max = std::max(totals.hold_max, site.hold_max.load(std::memory_order_relaxed));
+        }
+    }
+    registry_mutex.unlock();
+
+    std::vector<Totals> all;
+    for (auto &entry : sites) {
+        all.push_back(entry.second);
+    }
+    out << "Lock statistics (times in microseconds)" << std::endl;
+    for (const Totals &totals : all) {
+        out << "  " << totals.site
+            << "  acquires " << totals.acquires
+            << "  wait total " << totals.wait_total / 1000 << " max " << totals.wait_max / 1000
+            << "  hold total " << totals.hold_total / 1000 << " max " << totals.hold_max / 1000 << std::endl;
+    }
+    std::sort(all.begin(), all.end(), [](const Totals &a, const Totals &b) { return a.wait_max > b.wait_max; });
+    out << "Worst waiters:" << std::endl;
+    for (int i = 0; i < top && i < int(all.size()); i++) {
+        out << "  " << all[i].wait_max / 1000 << " us  " << all[i].site << std::endl;
+    }
+    std::sort(all.begin(), all.end(), [](const Totals &a, const Totals &b) { return a.hold_max > b.hold_max; });
+    out << "Longest critical sections:" << std::endl;
+    for (int i = 0; i < top && i < int(all.size()); i++) {
+        out << "  " << all[i].hold_max / 1000 << " us  " << all[i].site << std::endl;
+    }
+}
+
+#endif //SPACE_INVADERS_LOCK_STATS
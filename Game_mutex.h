@@ -0,0 +1,73 @@
+//
+// Created by piotrek on 14.06.17.
+//
+
+#ifndef SPACE_INVADERS_GAME_MUTEX_H
+#define SPACE_INVADERS_GAME_MUTEX_H
+
+#include <cstdint>
+#include <mutex>
+#include "Trace.h"
+#ifdef SPACE_INVADERS_LOCK_STATS
+#include <ostream>
+#endif
+
+/**
+ * The mutex guarding the game's shared state. Built with LOCK_STATS every lock records,
+ * per call site, how many times it was taken, how long the caller waited and how long
+ * it was held. The counters are kept per thread, so recording takes no extra locks.
+ * Without LOCK_STATS it only asks whether tracing is on before taking the mutex. While
+ * tracing, every hold is recorded as a slice of the holder's timeline, named after the mutex.
+ */
+class Game_mutex {
+public:
+    explicit Game_mutex(const char* _name) : name(_name) {}
+
+#ifdef SPACE_INVADERS_LOCK_STATS
+    /// The default arguments are evaluated at the caller, giving the call site for free
+    void lock(const char* file = __builtin_FILE(), int line = __builtin_LINE());
+
+    void unlock();
+
+    static void report(std::ostream &out, int top);
+#else
+    void lock() {
+        int64_t asked = Trace::isEnabled() ? Trace::clock() : -1;
+        mutex.lock();
+        traced(asked);
+    }
+
+    void unlock() {
+        int64_t since = traced_since;
+        int64_t wait = traced_wait;
+        mutex.unlock();
+        if (since >= 0) {
+            Trace::slice(name, "lock", since, wait);
+        }
+    }
+#endif
+
+    const char* getName() const { return name; }
+
+private:
+    std::mutex mutex;
+    const char* name;
+    int64_t traced_since = -1; // when the holder got the mutex, -1 unless tracing
+    int64_t traced_wait = 0; // how long the holder waited for it
+
+    /**
+     * Notes the start of the hold, just after the mutex was taken
+     * @param asked when the mutex was asked for, -1 unless tracing
+     */
+    void traced(int64_t asked) {
+        traced_since = asked < 0 ? -1 : Trace::clock();
+        traced_wait = traced_since - asked;
+    }
+#ifdef SPACE_INVADERS_LOCK_STATS
+    struct Site_counters* holder_site; // counters of the site holding the mutex
+    int64_t acquired_at; // when the holder got the mutex, in nanoseconds
+#endif
+};
+
+
+#endif //SPACE_INVADERS_GAME_MUTEX_H
@@ -0,0 +1,26 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#ifndef SPACE_INVADERS_GAME_RULES_H
+#define SPACE_INVADERS_GAME_RULES_H
+
+#include <chrono>
+
+/// Timing and balance of the game, shared by the interactive game and the headless world
+static const std::chrono::milliseconds frame_durtion(40); // 40 FPS
+static const std::chrono::milliseconds t_between_big_enemies(12000); // new big enemy every 8 seconds
+static const std::chrono::milliseconds t_between_small_enemies(4000); // new small enemy every 4 seconds
+static const int t_big_enemies_bullets= 4000;
+static const int t_small_enemies_bullets= 500;
+static const int small_bullets_speed = 30; // rows per second
+static const int big_bullets_speed = 15; //rows per sec_ond
+static const int big_slow_enemy_speed = 10; // columns per second
+static const int small_fast_enemy_speed = 20; // columns per second
+static const int big_formation_columns = 3; // big enemies in a new formation
+static const int small_formation_columns = 5; // small enemies in a new formation
+static const int formation_spacing = 2; // columns between the neighbouring members
+static const unsigned long script_volley = 8; // members of a formation shooting in a scripted volley
+static const int shields_count = 4; // shields per terminal width
+
+#endif //SPACE_INVADERS_GAME_RULES_H
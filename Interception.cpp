@@ -0,0 +1,85 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <algorithm>
+#include "Interception.h"
+
+/**
+ * Forgets the bullets of the previous sweep, keeping the memory
+ */
+void Interception::clear() {
+    spans.clear();
+}
+
+/**
+ * Adds a bullet to the next sweep, the done ones are skipped
+ * @param bullet the bullet
+ */
+void Interception::add(Bullet* bullet) {
+    if (bullet->isDone()) return;
+    spans.push_back({ bullet->getPos_x(), bullet->getPos_x() + bullet->getWidth() - 1, bullet });
+}
+
+/**
+ * Finds the pairs of bullets flying against each other which have met between the two moments,
+ * both bullets of a pair are done. A bullet stops at the first bullet it meets.
+ * @param from the time of the previous sweep in milliseconds
+ * @param to the current time in milliseconds
+ * @return the number of the bullets shot down
+ */
+int Interception::sweep(long from, long to) {
+    int intercepted = 0;
+    std::sort(spans.begin(), spans.end());
+    rising.clear();
+    falling.clear();
+    for (const Span &span : spans) {
+        prune(rising, span.first);
+        prune(falling, span.first);
+        bool up = span.bullet->move_direction == UP;
+        std::vector<Span> &opposite = up ? falling : rising;
+        bool hit = false;
+        for (const Span &other : opposite) {
+            if (other.bullet->isDone()) continue;
+            Bullet* up_bullet = up ? span.bullet : other.bullet;
+            Bullet* down_bullet = up ? other.bullet : span.bullet;
+            if (meet(up_bullet, down_bullet, from, to)) {
+                span.bullet->setDone();
+                other.bullet->setDone();
+                intercepted++;
+                hit = true;
+                break;
+            }
+        }
+        if (!hit) {
+            (up ? rising : falling).push_back(span);
+        }
+    }
+    return intercepted;
+}
+
+/**
+ * Two bullets flying against each other overlap during a single stretch of time,
+ * so they meet in the step if the rising one is not yet past the falling one at its start
+ * and has reached it at its end
+ */
+bool Interception::meet(Bullet* up, Bullet* down, long from, long to) {
+    int up_from = up->rowAt(from);
+    int up_to = up->rowAt(to);
+    int down_from = down->rowAt(from);
+    int down_to = down->rowAt(to);
+    return down_from < up_from + up->getHeight() && up_to < down_to + down->getHeight();
+}
+
+/**
+ * Drops the bullets which end left of the column
+ */
+void Interception::prune(std::vector<Span> &active, int column) {
+    unsigned long kept = 0;
+    for (unsigned long i = 0; i < active.size(); i++) {
+        if (active[i].last >= column && !active[i].bullet->isDone()) {
+            active[kept++] = active[i];
+        }
+    }
+    active.resize(kept);
+}
@@ -0,0 +1,44 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_INTERCEPTION_H
+#define SPACE_INVADERS_INTERCEPTION_H
+
+#include <vector>
+#include "Bullet.h"
+
+/**
+ * Bullets shooting each other down. All the bullets fly vertically and never change their columns,
+ * so the bullets are sorted by their first column and swept from left to right: only the bullets
+ * flying up and down which share a column are tested against each other. The test is swept over
+ * the whole step, so two bullets which have swapped rows during the step still meet.
+ */
+class Interception {
+public:
+    void clear();
+
+    void add(Bullet* bullet);
+
+    int sweep(long from, long to);
+
+private:
+    struct Span {
+        int first; // the first column of the bullet
+        int last; // the last column of the bullet
+        Bullet* bullet;
+
+        bool operator<(const Span &other) const { return first < other.first; }
+    };
+
+    std::vector<Span> spans;
+    std::vector<Span> rising; // bullets going up which still cover the swept column
+    std::vector<Span> falling; // bullets going down which still cover the swept column
+
+    static bool meet(Bullet* up, Bullet* down, long from, long to);
+
+    static void prune(std::vector<Span> &active, int column);
+};
+
+
+#endif //SPACE_INVADERS_INTERCEPTION_H
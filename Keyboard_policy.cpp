@@ -0,0 +1,40 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#include <ncurses.h>
+#include "Keyboard_policy.h"
+#include "Trace.h"
+#include "Memory_stats.h"
+#include "Braille_layer.h"
+
+static const int SPACE = 32;
+
+/**
+ * Move your ship left with 'a' and right with 'd', shoot with space, quit with 'q',
+ * switch the tracing on and off with 't', the memory line with 'm' and the Braille dots with 'b'
+ */
+Action Keyboard_policy::act(const Observation &) {
+    int key = getch();
+    switch (key) {
+        case 'q':
+            return ACTION_QUIT;
+        case SPACE:
+            return ACTION_FIRE;
+        case 'a':
+            return ACTION_LEFT;
+        case 'd':
+            return ACTION_RIGHT;
+        case 't':
+            Trace::toggle();
+            return ACTION_NONE;
+        case 'm':
+            Memory_stats::toggleHud();
+            return ACTION_NONE;
+        case 'b':
+            Braille_layer::toggle();
+            return ACTION_NONE;
+        default:
+            return ACTION_NONE;
+    }
+}
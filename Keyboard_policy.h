@@ -0,0 +1,19 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#ifndef SPACE_INVADERS_KEYBOARD_POLICY_H
+#define SPACE_INVADERS_KEYBOARD_POLICY_H
+
+#include "Policy.h"
+
+/**
+ * The human player: waits for a key and ignores the observation
+ */
+class Keyboard_policy : public Policy {
+public:
+    Action act(const Observation &observation);
+};
+
+
+#endif //SPACE_INVADERS_KEYBOARD_POLICY_H
@@ -0,0 +1,162 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include "Memory_stats.h"
+
+/**
+ * Counters of one actor class
+ */
+struct Kind_counters {
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> frees;
+    std::atomic<uint64_t> bytes; // live
+    std::atomic<uint64_t> peak_bytes;
+};
+
+/**
+ * The latest sample of one vector
+ */
+struct Vector_sample {
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> size;
+    std::atomic<uint64_t> capacity;
+    std::atomic<uint64_t> element;
+};
+
+/// Zero initialized, being static, so the counting works from the first allocation
+static Kind_counters kinds[Memory_stats::KINDS];
+static Vector_sample vectors[Memory_stats::VECTORS];
+static const char* kind_names[Memory_stats::KINDS] = {
+        "SmallBullet", "BigBullet", "Enemy_small_fast", "Enemy_big_slow", "Player", "Shield", "Formation" };
+static const char* kind_tags[Memory_stats::KINDS] = { "sb", "bb", "esf", "ebs", "pl", "sh", "fo" };
+
+std::atomic_bool Memory_stats::hud(false);
+
+/**
+ * Allocates an object of the class and counts it
+ * @param kind the object's class
+ * @param bytes the object's size
+ * @return the memory for the object
+ */
+void* Memory_stats::allocate(Kind kind, std::size_t bytes) {
+    void* object = ::operator new(bytes);
+    Kind_counters &counters = kinds[kind];
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    uint64_t live = counters.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    uint64_t peak = counters.peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !counters.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return object;
+}
+
+/**
+ * Frees an object of the class and counts it
+ * @param kind the object's class
+ * @param object the object's memory
+ * @param bytes the object's size
+ */
+void Memory_stats::release(Kind kind, void* object, std::size_t bytes) {
+    Kind_counters &counters = kinds[kind];
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    ::operator delete(object);
+}
+
+/**
+ * Records the current size of a vector of pointers, to be called by the vector's owner
+ * @param name the vector's name, a string literal
+ * @param size the vector's size
+ * @param capacity the vector's capacity
+ * @param element the size of an element
+ */
+void Memory_stats::sampleVector(const char* name, std::size_t size, std::size_t capacity, std::size_t element) {
+    for (Vector_sample &sample : vectors) {
+        const char* taken = sample.name.load(std::memory_order_acquire);
+        if (taken == nullptr) {
+            if (!sample.name.compare_exchange_strong(taken, name, std::memory_order_acq_rel) && taken != name) {
+                continue;
+            }
+        } else if (taken != name) {
+            continue;
+        }
+        sample.size.store(size, std::memory_order_relaxed);
+        sample.capacity.store(capacity, std::memory_order_relaxed);
+        sample.element.store(element, std::memory_order_relaxed);
+        return;
+    }
+}
+
+/**
+ * @param bytes the number of bytes
+ * @return the bytes in kibibytes, with one decimal
+ */
+static std::string kibibytes(uint64_t bytes) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1fK", bytes / 1024.0);
+    return text;
+}
+
+/**
+ * @return a single line for the HUD: the live objects of every class, their bytes,
+ *         the bytes of the vectors and how many of them are spare capacity
+ */
+std::string Memory_stats::summary() {
+    std::string line = "MEM";
+    uint64_t live_bytes = 0;
+    for (int kind = 0; kind < KINDS; kind++) {
+        uint64_t live = kinds[kind].allocations.load(std::memory_order_relaxed)
+                        - kinds[kind].frees.load(std::memory_order_relaxed);
+        line += std::string(" ") + kind_tags[kind] + " " + std::to_string(live);
+        live_bytes += kinds[kind].bytes.load(std::memory_order_relaxed);
+    }
+    uint64_t vector_bytes = 0;
+    uint64_t spare_bytes = 0;
+    for (Vector_sample &sample : vectors) {
+        if (sample.name.load(std::memory_order_acquire) == nullptr) continue;
+        uint64_t element = sample.element.load(std::memory_order_relaxed);
+        uint64_t capacity = sample.capacity.load(std::memory_order_relaxed);
+        vector_bytes += capacity * element;
+        spare_bytes += (capacity - sample.size.load(std::memory_order_relaxed)) * element;
+    }
+    line += " | " + kibibytes(live_bytes) + " live | vectors " + kibibytes(vector_bytes)
+            + ", " + kibibytes(spare_bytes) + " spare";
+    return line;
+}
+
+/**
+ * Prints the counters of every class and the latest sample of every vector
+ * @param out the stream
+ */
+void Memory_stats::report(std::ostream &out) {
+    out << "Memory by class (bytes)" << std::endl;
+    for (int kind = 0; kind < KINDS; kind++) {
+        uint64_t allocations = kinds[kind].allocations.load(std::memory_order_relaxed);
+        uint64_t frees = kinds[kind].frees.load(std::memory_order_relaxed);
+        out << "  " << kind_names[kind]
+            << "  allocations " << allocations << "  frees " << frees << "  live " << allocations - frees
+            << "  live bytes " << kinds[kind].bytes.load(std::memory_order_relaxed)
+            << "  peak " << kinds[kind].peak_bytes.load(std::memory_order_relaxed) << std::endl;
+    }
+    out << "Memory by vector (bytes)" << std::endl;
+    for (Vector_sample &sample : vectors) {
+        const char* name = sample.name.load(std::memory_order_acquire);
+        if (name == nullptr) continue;
+        uint64_t size = sample.size.load(std::memory_order_relaxed);
+        uint64_t capacity = sample.capacity.load(std::memory_order_relaxed);
+        uint64_t element = sample.element.load(std::memory_order_relaxed);
+        out << "  " << name << "  size " << size << "  capacity " << capacity
+            << "  bytes " << capacity * element << "  spare " << (capacity - size) * element << std::endl;
+    }
+}
+
+/**
+ * Shows or hides the HUD line
+ * @return true if the line is shown now
+ */
+bool Memory_stats::toggleHud() {
+    hud = !hud;
+    return hud;
+}
@@ -0,0 +1,55 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_MEMORY_STATS_H
+#define SPACE_INVADERS_MEMORY_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+/**
+ * Where the memory goes: allocations, frees, live objects and bytes of every actor class,
+ * counted by the classes' own operator new and delete, and the sizes and capacities
+ * of the shared vectors, sampled by their owners. The counters are atomics, so any thread
+ * can allocate and the live summary can be read while the game runs.
+ */
+class Memory_stats {
+public:
+    enum Kind { SMALL_BULLET, BIG_BULLET, ENEMY_SMALL_FAST, ENEMY_BIG_SLOW, PLAYER, SHIELD, FORMATION, KINDS };
+    static const int VECTORS = 16; // the most vectors sampled
+
+    static void* allocate(Kind kind, std::size_t bytes);
+
+    static void release(Kind kind, void* object, std::size_t bytes);
+
+    static void sampleVector(const char* name, std::size_t size, std::size_t capacity, std::size_t element);
+
+    static std::string summary();
+
+    static void report(std::ostream &out);
+
+    static bool toggleHud();
+
+    static bool isHudShown() { return hud.load(std::memory_order_relaxed); }
+
+private:
+    static std::atomic_bool hud;
+};
+
+/**
+ * Base of the counted classes: their objects are allocated and freed through the accounting.
+ * Deleting through a base pointer reaches the right kind, the destructors being virtual.
+ */
+template <Memory_stats::Kind K>
+class Memory_counted {
+public:
+    static void* operator new(std::size_t bytes) { return Memory_stats::allocate(K, bytes); }
+
+    static void operator delete(void* object, std::size_t bytes) { Memory_stats::release(K, object, bytes); }
+};
+
+
+#endif //SPACE_INVADERS_MEMORY_STATS_H
@@ -0,0 +1,106 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <algorithm>
+#include "Narrowphase.h"
+#include "Trace.h"
+
+/**
+ * Orders the hits by the bullets' places, then by the targets
+ */
+bool Narrowphase::Hit::operator<(const Hit &other) const {
+    if (bullet != other.bullet) return bullet < other.bullet;
+    return target < other.target;
+}
+
+/**
+ * Starts the workers, the calling thread checks the first part itself
+ * @param _threads the number of threads checking the bullets, at least 1
+ */
+Narrowphase::Narrowphase(unsigned int _threads)
+        : threads(std::max(_threads, 1u)), buffers(threads), generation(0), pending(0), stopping(false),
+          task(nullptr), count(0), chunk(0), parts(1) {
+    for (unsigned int part = 1; part < threads; part++) {
+        workers.emplace_back(&Narrowphase::work, this, part);
+    }
+}
+
+Narrowphase::~Narrowphase() {
+    mutex.lock();
+    stopping = true;
+    mutex.unlock();
+    started.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Checks all the bullets and returns their hits in the bullets' order
+ * @param bullets the number of the bullets
+ * @param test the function checking a range of the bullets, called concurrently for disjoint ranges
+ * @return the hits, valid until the next detection
+ */
+const std::vector<Narrowphase::Hit> &Narrowphase::detect(unsigned long bullets, const Detect &test) {
+    unsigned int used = (unsigned int) std::min((unsigned long) threads, std::max(bullets / GRAIN, 1UL));
+    mutex.lock();
+    task = &test;
+    count = bullets;
+    parts = used;
+    chunk = (bullets + used - 1) / used;
+    pending = used - 1;
+    if (used > 1) {
+        generation++;
+    }
+    mutex.unlock();
+    if (used > 1) {
+        started.notify_all();
+    }
+    check(0);
+    if (used > 1) {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return pending == 0; });
+    }
+    hits.clear();
+    for (unsigned int part = 0; part < used; part++) {
+        hits.insert(hits.end(), buffers[part].begin(), buffers[part].end());
+    }
+    std::sort(hits.begin(), hits.end());
+    return hits;
+}
+
+/**
+ * The worker's loop: waits for a detection and checks its part, if the detection has one for it
+ * @param part the worker's part
+ */
+void Narrowphase::work(unsigned int part) {
+    Trace::nameThread("narrowphase");
+    unsigned long seen = 0;
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        started.wait(lock, [this, seen] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        if (part >= parts) continue;
+        lock.unlock();
+        check(part);
+        lock.lock();
+        if (--pending == 0) {
+            finished.notify_one();
+        }
+    }
+}
+
+/**
+ * Checks one part of the bullets into its buffer
+ * @param part the part
+ */
+void Narrowphase::check(unsigned int part) {
+    Trace::Scope scope("narrowphase part");
+    std::vector<Hit> &buffer = buffers[part];
+    buffer.clear();
+    unsigned long first = std::min(count, part * chunk);
+    unsigned long last = std::min(count, first + chunk);
+    (*task)(first, last, buffer);
+}
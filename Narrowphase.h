@@ -0,0 +1,73 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_NARROWPHASE_H
+#define SPACE_INVADERS_NARROWPHASE_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "Game_actor.h"
+
+/**
+ * Checks the bullets against their targets on several cores. The bullets are split into
+ * contiguous parts, one per thread, and every thread records the hits it finds into a buffer
+ * of its own, touching nothing but the bullets of its part. The hits are then merged and sorted
+ * by the bullets' places, so they come out the same whatever the number of threads.
+ * Too few bullets are checked by the calling thread alone.
+ */
+class Narrowphase {
+public:
+    static const unsigned long GRAIN = 256; // the fewest bullets worth a thread of their own
+
+    struct Hit {
+        unsigned long bullet; // the bullet's place among the checked bullets
+        int target; // which of the caller's collections the enemy belongs to
+        Game_actor* enemy;
+        int damage;
+
+        bool operator<(const Hit &other) const;
+    };
+
+    /// Checks the bullets from first up to last, appending their hits to the buffer
+    typedef std::function<void(unsigned long first, unsigned long last, std::vector<Hit> &hits)> Detect;
+
+    explicit Narrowphase(unsigned int _threads);
+
+    ~Narrowphase();
+
+    Narrowphase(const Narrowphase &) = delete;
+
+    Narrowphase &operator=(const Narrowphase &) = delete;
+
+    const std::vector<Hit> &detect(unsigned long bullets, const Detect &test);
+
+    unsigned int getThreads() const { return threads; }
+
+private:
+    unsigned int threads;
+    std::vector<std::thread> workers;
+    std::vector<std::vector<Hit>> buffers; // one per part
+    std::vector<Hit> hits;
+
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    unsigned long generation; // counts the detections handed to the workers
+    unsigned int pending; // the workers still checking their parts
+    bool stopping;
+    const Detect* task;
+    unsigned long count;
+    unsigned long chunk;
+    unsigned int parts;
+
+    void work(unsigned int part);
+
+    void check(unsigned int part);
+};
+
+
+#endif //SPACE_INVADERS_NARROWPHASE_H
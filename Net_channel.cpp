@@ -0,0 +1,106 @@
+//
+// Created by piotrek on 17.06.17.
+//
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "Net_channel.h"
+
+Net_channel::Net_channel(int _fd) {
+    fd = _fd;
+}
+
+Net_channel::~Net_channel() {
+    close();
+}
+
+static bool address(const char* path, sockaddr_un &addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (std::strlen(path) >= sizeof(addr.sun_path)) return false;
+    std::strcpy(addr.sun_path, path);
+    return true;
+}
+
+/**
+ * Creates a listening socket, replacing a stale socket file
+ * @param path the path of the socket
+ * @return the socket or -1
+ */
+int Net_channel::listen(const char* path) {
+    sockaddr_un addr;
+    if (!address(path, addr)) return -1;
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    unlink(path);
+    if (bind(sock, (sockaddr*) &addr, sizeof(addr)) != 0 || ::listen(sock, Net_message::MAX_PLAYERS) != 0) {
+        ::close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+/**
+ * @param path the path of the socket
+ * @return the connected socket or -1
+ */
+int Net_channel::connect(const char* path) {
+    sockaddr_un addr;
+    if (!address(path, addr)) return -1;
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    if (::connect(sock, (sockaddr*) &addr, sizeof(addr)) != 0) {
+        ::close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+/**
+ * @return false if the other side has gone
+ */
+bool Net_channel::send(const Net_message &message) {
+    const char* bytes = (const char*) &message;
+    size_t left = sizeof(message);
+    while (fd >= 0 && left > 0) {
+        ssize_t sent = ::send(fd, bytes, left, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            close();
+            break;
+        }
+        bytes += sent;
+        left -= size_t(sent);
+    }
+    return fd >= 0;
+}
+
+/**
+ * Takes the next message, reading what has arrived without waiting
+ * @param message the message taken
+ * @return false if there is no whole message yet
+ */
+bool Net_channel::receive(Net_message &message) {
+    if (fd >= 0 && buffer.size() < sizeof(message)) {
+        char bytes[4096];
+        ssize_t count = recv(fd, bytes, sizeof(bytes), MSG_DONTWAIT);
+        if (count > 0) {
+            buffer.insert(buffer.end(), bytes, bytes + count);
+        } else if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            close();
+        }
+    }
+    if (buffer.size() < sizeof(message)) return false;
+    std::memcpy(&message, buffer.data(), sizeof(message));
+    buffer.erase(buffer.begin(), buffer.begin() + sizeof(message));
+    return true;
+}
+
+void Net_channel::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
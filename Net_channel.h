@@ -0,0 +1,64 @@
+//
+// Created by piotrek on 17.06.17.
+//
+
+#ifndef SPACE_INVADERS_NET_CHANNEL_H
+#define SPACE_INVADERS_NET_CHANNEL_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * The only message of the co-op protocol. The server greets every client with WELCOME,
+ * the clients send the INPUT of each of their frames and the server answers with
+ * the CONFIRM of every frame it has simulated.
+ */
+struct Net_message {
+    static const int MAX_PLAYERS = 8;
+
+    enum Type : int32_t {
+        WELCOME, INPUT, CONFIRM
+    };
+
+    int32_t type;
+    int32_t frame;
+    int32_t player; // WELCOME: the client's player, INPUT: the sending player
+    int32_t players;
+    uint32_t seed;
+    int32_t columns;
+    int32_t rows;
+    uint32_t checksum; // CONFIRM: the server's world after the frame
+    uint8_t actions[MAX_PLAYERS]; // INPUT: actions[0], CONFIRM: the actions of all the players
+};
+
+/**
+ * A message stream over a Unix domain socket. Sending blocks, receiving never does:
+ * the bytes which have arrived are buffered until a whole message is there.
+ */
+class Net_channel {
+public:
+    explicit Net_channel(int _fd);
+
+    ~Net_channel();
+
+    static int listen(const char* path);
+
+    static int connect(const char* path);
+
+    bool send(const Net_message &message);
+
+    bool receive(Net_message &message);
+
+    bool isClosed() const { return fd < 0; }
+
+    int getFd() const { return fd; }
+
+private:
+    int fd;
+    std::vector<char> buffer;
+
+    void close();
+};
+
+
+#endif //SPACE_INVADERS_NET_CHANNEL_H
@@ -0,0 +1,83 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#include <cstring>
+#include <algorithm>
+#include "Observation.h"
+
+/**
+ * Wraps the caller's buffers
+ * @param _cells the grid, at least _columns * _rows bytes, row after row
+ * @param _hit_points where the player's hit points are written
+ * @param _columns the width of the window
+ * @param _rows the height of the window
+ */
+Observation::Observation(unsigned char* _cells, int* _hit_points, int _columns, int _rows) {
+    cells = _cells;
+    hit_points = _hit_points;
+    columns = _columns;
+    rows = _rows;
+    origin_x = 0;
+    origin_y = 0;
+}
+
+/**
+ * Empties the grid and moves the window
+ * @param _origin_x the world column shown in the first column of the grid
+ * @param _origin_y the world row shown in the first row of the grid
+ */
+void Observation::clear(int _origin_x, int _origin_y) {
+    origin_x = _origin_x;
+    origin_y = _origin_y;
+    std::memset(cells, EMPTY, size_t(columns) * size_t(rows));
+    *hit_points = 0;
+}
+
+/**
+ * Marks the actor's bounding box, clipped to the window
+ * @param actor the actor
+ * @param cell the type to be written
+ */
+void Observation::stamp(const Game_actor* actor, Cell cell) {
+    stamp(actor->getPos_x(), actor->getPos_y(), actor->getWidth(), actor->getHeight(), cell);
+}
+
+/**
+ * Marks the rectangle given in world coordinates, clipped to the window
+ * @param x the left column
+ * @param y the top row
+ * @param width the number of columns
+ * @param height the number of rows
+ * @param cell the type to be written
+ */
+void Observation::stamp(int x, int y, int width, int height, Cell cell) {
+    int left = std::max(x - origin_x, 0);
+    int right = std::min(x + width - origin_x, columns);
+    int top = std::max(y - origin_y, 0);
+    int bottom = std::min(y + height - origin_y, rows);
+    for (int y = top; y < bottom; y++) {
+        if (left < right) {
+            std::memset(cells + y * columns + left, cell, size_t(right - left));
+        }
+    }
+}
+
+/**
+ * Marks the standing cells of the shield, clipped to the window
+ * @param shield the shield
+ */
+void Observation::stampShield(const Shield* shield) {
+    for (int i = 0; i < Shield::ROWS; i++) {
+        int y = shield->getPos_y() + i - origin_y;
+        if (y < 0 || y >= rows) continue;
+        uint64_t row = shield->getCells(i);
+        while (row) {
+            int x = shield->getPos_x() + __builtin_ctzll(row) - origin_x;
+            if (x >= 0 && x < columns) {
+                cells[y * columns + x] = SHIELD;
+            }
+            row &= row - 1;
+        }
+    }
+}
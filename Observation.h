@@ -0,0 +1,54 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#ifndef SPACE_INVADERS_OBSERVATION_H
+#define SPACE_INVADERS_OBSERVATION_H
+
+#include "Game_actor.h"
+#include "Shield.h"
+
+/**
+ * What a policy sees in a tick: a dense grid of cell types covering a window of the world,
+ * plus the player's hit points. The buffers are owned by the caller and are only written,
+ * so observing allocates nothing and many observations can share one contiguous array.
+ */
+class Observation {
+public:
+    enum Cell : unsigned char {
+        EMPTY, PLAYER, SHIELD, BIG_ENEMY, SMALL_ENEMY, ENEMY_BULLET, PLAYER_BULLET, ALLY
+    };
+
+    Observation(unsigned char* _cells, int* _hit_points, int _columns, int _rows);
+
+    void clear(int _origin_x, int _origin_y);
+
+    void stamp(const Game_actor* actor, Cell cell);
+
+    void stamp(int x, int y, int width, int height, Cell cell);
+
+    void stampShield(const Shield* shield);
+
+    void setHit_points(int hp) { *hit_points = hp; }
+
+    int getHit_points() const { return *hit_points; }
+
+    Cell at(int x, int y) const { return Cell(cells[y * columns + x]); }
+
+    int getColumns() const { return columns; }
+
+    int getRows() const { return rows; }
+
+    const unsigned char* getCells() const { return cells; }
+
+private:
+    unsigned char* cells;
+    int* hit_points;
+    int columns;
+    int rows;
+    int origin_x;
+    int origin_y;
+};
+
+
+#endif //SPACE_INVADERS_OBSERVATION_H
@@ -0,0 +1,124 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <sys/ioctl.h>
+#include <algorithm>
+#include "Output_pacer.h"
+#include "Trace.h"
+
+/**
+ * Starts the writer thread
+ * @param _fd the terminal's file descriptor
+ * @param _frame the time of a frame
+ */
+Output_pacer::Output_pacer(int _fd, std::chrono::milliseconds _frame)
+        : fd(_fd), frame_nanos((long) std::chrono::duration_cast<std::chrono::nanoseconds>(_frame).count()),
+          busy(false), stopping(false), sample_queue(0), sample_at(std::chrono::steady_clock::now()),
+          bytes_per_second(0), shown(0), coalesced(0), longest_write(0) {
+    writer = std::thread(&Output_pacer::run, this);
+}
+
+Output_pacer::~Output_pacer() {
+    stop();
+}
+
+/**
+ * Hands the window's frame over to the writer, unless the writer or the link is still busy
+ * with the previous ones. Called by the rendering thread instead of refresh().
+ * @param window the window to show
+ * @return true if the frame will be shown, false if it was left for the next one
+ */
+bool Output_pacer::present(WINDOW* window) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (busy) {
+        coalesced++;
+        return false;
+    }
+    long queue = queued();
+    if (queue >= 0) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        long elapsed = (long) std::chrono::duration_cast<std::chrono::nanoseconds>(now - sample_at).count();
+        /// Nothing was written since the last sample, so while the queue stays non empty
+        /// the link is the bottleneck and what has drained is its speed
+        if (queue > 0 && sample_queue > queue && elapsed > 0) {
+            double rate = (sample_queue - queue) * 1e9 / elapsed;
+            bytes_per_second = bytes_per_second == 0 ? rate : 0.75 * bytes_per_second + 0.25 * rate;
+        }
+        sample_queue = queue;
+        sample_at = now;
+        if (queue > bytes_per_second * frame_nanos / 1e9) {
+            coalesced++;
+            return false;
+        }
+    }
+    wnoutrefresh(window);
+    busy = true;
+    shown++;
+    lock.unlock();
+    wake.notify_one();
+    return true;
+}
+
+/**
+ * Waits for the writer to finish the frame it has and stops it.
+ * The caller may refresh the terminal itself afterwards.
+ */
+void Output_pacer::stop() {
+    mutex.lock();
+    stopping = true;
+    mutex.unlock();
+    wake.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+/**
+ * Prints how many frames were shown and skipped, and what was learnt about the link
+ * @param out the stream
+ */
+void Output_pacer::printStats(std::ostream &out) const {
+    out << "output: " << shown << " frames shown, " << coalesced << " coalesced, ";
+    if (bytes_per_second > 0) {
+        out << "link " << (long) bytes_per_second << " bytes/s";
+    } else {
+        out << "link speed not measured";
+    }
+    out << ", longest write " << longest_write / 1000000.0 << " ms" << std::endl;
+}
+
+/**
+ * The writer thread: sends every handed over frame to the terminal
+ */
+void Output_pacer::run() {
+    Trace::nameThread("output");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return busy || stopping; });
+        if (!busy) return;
+        lock.unlock();
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        {
+            Trace::Scope scope("doupdate", "output");
+            doupdate();
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        long queue = queued();
+        lock.lock();
+        longest_write = std::max(longest_write,
+                                 (long) std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+        sample_queue = queue;
+        sample_at = end;
+        busy = false;
+    }
+}
+
+/**
+ * @return the bytes written but not yet sent by the terminal, -1 when the output is not a terminal
+ */
+long Output_pacer::queued() const {
+    int bytes = 0;
+    if (ioctl(fd, TIOCOUTQ, &bytes) < 0) return -1;
+    return bytes;
+}
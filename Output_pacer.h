@@ -0,0 +1,64 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_OUTPUT_PACER_H
+#define SPACE_INVADERS_OUTPUT_PACER_H
+
+#include <ncurses.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+/**
+ * Writes the frames to the terminal without ever making the game wait for a slow link.
+ * The terminal is updated by a writer thread; the rendering thread only hands a finished
+ * frame over, which is a copy in memory. A frame is handed over only when the writer is idle
+ * and the terminal's output queue is short enough for the link to drain in one frame, the speed
+ * of the link being measured from how fast the queue drains. Otherwise the frame is skipped
+ * and its changes go out with the next one, ncurses sending only what differs from the screen
+ * the terminal last got.
+ */
+class Output_pacer {
+public:
+    Output_pacer(int _fd, std::chrono::milliseconds _frame);
+
+    ~Output_pacer();
+
+    Output_pacer(const Output_pacer &) = delete;
+
+    Output_pacer &operator=(const Output_pacer &) = delete;
+
+    bool present(WINDOW* window);
+
+    void stop();
+
+    void printStats(std::ostream &out) const;
+
+private:
+    int fd;
+    long frame_nanos;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool busy; // the writer has a frame to write
+    bool stopping;
+
+    /// The link, measured from the output queue while the writer is idle
+    long sample_queue; // bytes queued at the last sample, -1 when the output is not a terminal
+    std::chrono::steady_clock::time_point sample_at;
+    double bytes_per_second; // 0 until the link has been seen saturated, ptys never report a queue
+
+    unsigned long shown;
+    unsigned long coalesced;
+    long longest_write; // nanoseconds
+
+    void run();
+
+    long queued() const;
+};
+
+
+#endif //SPACE_INVADERS_OUTPUT_PACER_H
@@ -0,0 +1,149 @@
+//
+// Created by piotrek on 15.06.17.
+//
+
+#include <cstring>
+#include <ncurses.h>
+#include "Particles.h"
+
+/// Four floats processed at once, loaded and stored without alignment requirements
+typedef float float4 __attribute__((vector_size(16), aligned(4)));
+
+static const float gravity = 12.0f; // rows per second squared
+static const float aspect = 2.0f; // terminal cells are about twice as high as wide
+
+/**
+ * Creates an empty buffer. The arrays are padded to a multiple of four,
+ * so the update never needs a scalar tail.
+ * @param _capacity the maximum number of live particles
+ */
+Particles::Particles(int _capacity) {
+    capacity = _capacity;
+    count = 0;
+    unsigned long padded = (unsigned long) ((capacity + 3) / 4 * 4);
+    pos_x.resize(padded);
+    pos_y.resize(padded);
+    vel_x.resize(padded);
+    vel_y.resize(padded);
+    life.resize(padded);
+    seed = 2463534242u;
+}
+
+/**
+ * @return a pseudo random number from [-1, 1), xorshift is enough for debris
+ */
+float Particles::random() {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return float(seed >> 8) / float(1 << 23) - 1.0f;
+}
+
+/**
+ * Throws particles in random directions from the given point.
+ * Particles over the capacity are dropped.
+ * @param x the column of the explosion
+ * @param y the row of the explosion
+ * @param amount the number of particles
+ * @param speed the maximum speed in columns per second
+ * @param lifetime the maximum lifetime in seconds
+ */
+void Particles::emit(float x, float y, int amount, float speed, float lifetime) {
+    for (int i = 0; i < amount && count < capacity; i++, count++) {
+        pos_x[count] = x;
+        pos_y[count] = y;
+        vel_x[count] = random() * speed;
+        vel_y[count] = random() * speed / aspect;
+        life[count] = lifetime * (0.6f + 0.4f * random());
+    }
+}
+
+/**
+ * Moves all the particles by dt and removes the dead ones
+ * @param dt the time since the last update in seconds
+ */
+void Particles::update(float dt) {
+    float* __restrict x = pos_x.data();
+    float* __restrict y = pos_y.data();
+    float* __restrict vx = vel_x.data();
+    float* __restrict vy = vel_y.data();
+    float* __restrict l = life.data();
+    float4 dt4 = { dt, dt, dt, dt };
+    float4 g4 = dt4 * gravity;
+    for (int i = 0; i < count; i += 4) {
+        float4 vy4 = *(float4*) (vy + i);
+        *(float4*) (x + i) += *(float4*) (vx + i) * dt4;
+        *(float4*) (y + i) += vy4 * dt4;
+        *(float4*) (vy + i) = vy4 + g4;
+        *(float4*) (l + i) -= dt4;
+    }
+    compact();
+}
+
+/**
+ * Moves the live particles to the front, keeping their order
+ */
+void Particles::compact() {
+    int alive = 0;
+    for (int i = 0; i < count; i++) {
+        if (life[i] > 0.0f) {
+            pos_x[alive] = pos_x[i];
+            pos_y[alive] = pos_y[i];
+            vel_x[alive] = vel_x[i];
+            vel_y[alive] = vel_y[i];
+            life[alive] = life[i];
+            alive++;
+        }
+    }
+    count = alive;
+}
+
+/**
+ * Draws the particles inside the viewport. They are binned into a grid first,
+ * then every run of occupied cells in a row is printed with one call.
+ * @param view the viewport
+ */
+void Particles::draw(const Viewport &view) {
+    int columns = view.getColumns();
+    int rows = view.getRows();
+    cells.resize((unsigned long) (columns * rows));
+    std::memset(cells.data(), 0, cells.size());
+    float origin_x = float(view.getOrigin_x());
+    float origin_y = float(view.getOrigin_y());
+    for (int i = 0; i < count; i++) {
+        float fx = pos_x[i] - origin_x;
+        float fy = pos_y[i] - origin_y;
+        if (fx < 0.0f || fy < 0.0f || fx >= columns || fy >= rows) continue;
+        cells[int(fy) * columns + int(fx)] = life[i] > 0.6f ? '*' : life[i] > 0.3f ? '+' : '.';
+    }
+    for (int y = 0; y < rows; y++) {
+        const char* row = cells.data() + y * columns;
+        int x = 0;
+        while (x < columns) {
+            if (!row[x]) {
+                x++;
+                continue;
+            }
+            int start = x;
+            while (x < columns && row[x]) x++;
+            mvaddnstr(y, start, row + start, x - start);
+        }
+    }
+}
+
+/**
+ * Composites every particle in the viewport as a single dot
+ * @param view the viewport
+ * @param layer the layer of the frame
+ * @param color the color pair
+ */
+void Particles::drawDots(const Viewport &view, Braille_layer &layer, short color) {
+    float origin_x = float(view.getOrigin_x());
+    float origin_y = float(view.getOrigin_y());
+    for (int i = 0; i < count; i++) {
+        float fx = pos_x[i] - origin_x;
+        float fy = pos_y[i] - origin_y;
+        if (fx < 0.0f || fy < 0.0f) continue;
+        layer.plot(int(fx * Braille_layer::DOT_COLUMNS), int(fy * Braille_layer::DOT_ROWS), color);
+    }
+}
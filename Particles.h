@@ -0,0 +1,50 @@
+//
+// Created by piotrek on 15.06.17.
+//
+
+#ifndef SPACE_INVADERS_PARTICLES_H
+#define SPACE_INVADERS_PARTICLES_H
+
+#include <vector>
+#include <cstdint>
+#include "Viewport.h"
+#include "Braille_layer.h"
+
+/**
+ * Explosion debris. The particles are kept as a structure of arrays, so the update
+ * runs over plain float arrays four lanes at a time, and the dead particles are
+ * squeezed out in a single compaction pass per frame. Drawing bins the particles
+ * into a screen sized grid and prints whole runs of cells at once.
+ */
+class Particles {
+public:
+    explicit Particles(int _capacity);
+
+    void emit(float x, float y, int amount, float speed, float lifetime);
+
+    void update(float dt);
+
+    void draw(const Viewport &view);
+
+    void drawDots(const Viewport &view, Braille_layer &layer, short color);
+
+    int size() const { return count; }
+
+private:
+    int capacity;
+    int count;
+    std::vector<float> pos_x;
+    std::vector<float> pos_y;
+    std::vector<float> vel_x;
+    std::vector<float> vel_y;
+    std::vector<float> life; // seconds left
+    std::vector<char> cells; // the screen grid used by draw
+    uint32_t seed;
+
+    float random();
+
+    void compact();
+};
+
+
+#endif //SPACE_INVADERS_PARTICLES_H
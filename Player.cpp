@@ -17,13 +17,15 @@ Player::Player(int _pos_x, int _pos_y, int _min_x, int _max_x, int _min_y, int _
  *  |_/$\_|
  *
  */
-void Player::drawActor() {
-    mvprintw(pos_y, pos_x,"|");
-    mvprintw(pos_y, pos_x+1, "_");
-    mvprintw(pos_y, pos_x+2, "/");
-    mvprintw(pos_y, pos_x+3, "$");
-    mvprintw(pos_y, pos_x+4, "\\");
-    mvprintw(pos_y, pos_x+5, "_");
-    mvprintw(pos_y, pos_x+6, "|");
+void Player::drawActor(const Viewport &view) {
+    int x = pos_x - view.getOrigin_x();
+    int y = pos_y - view.getOrigin_y();
+    mvprintw(y, x,"|");
+    mvprintw(y, x+1, "_");
+    mvprintw(y, x+2, "/");
+    mvprintw(y, x+3, "$");
+    mvprintw(y, x+4, "\\");
+    mvprintw(y, x+5, "_");
+    mvprintw(y, x+6, "|");
 }
 
@@ -7,11 +7,12 @@
 
 #include <ncurses.h>
 #include "Game_actor.h"
+#include "Memory_stats.h"
 
-class Player : public Game_actor{
+class Player : public Game_actor, public Memory_counted<Memory_stats::PLAYER> {
 public:
     Player(int _pos_x, int _pos_y, int _min_x, int _max_x, int _min_y, int _max_y);
-    void drawActor();
+    void drawActor(const Viewport &view);
 };
 
 
@@ -0,0 +1,21 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#ifndef SPACE_INVADERS_POLICY_H
+#define SPACE_INVADERS_POLICY_H
+
+#include "Action.h"
+#include "Observation.h"
+
+/**
+ * Decides what the player does. Called once per tick with the current observation.
+ */
+class Policy {
+public:
+    virtual ~Policy() {}
+
+    virtual Action act(const Observation &observation) = 0;
+};
+
+#endif //SPACE_INVADERS_POLICY_H
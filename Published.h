@@ -0,0 +1,42 @@
+//
+// Created by piotrek on 18.06.17.
+//
+
+#ifndef SPACE_INVADERS_PUBLISHED_H
+#define SPACE_INVADERS_PUBLISHED_H
+
+#include <atomic>
+#include "Epoch.h"
+
+/**
+ * An immutable copy of a value for the readers which don't take its lock. The writer,
+ * still under the lock, publishes a fresh copy after each change, and the old copy
+ * is retired, so a reader holding an Epoch::Guard can keep iterating it.
+ */
+template <typename T>
+class Published {
+public:
+    Published() : current(new T()) {}
+
+    ~Published() { delete current.load(); }
+
+    /**
+     * @return the last published copy, valid while the caller holds an Epoch::Guard
+     */
+    const T &read() const { return *current.load(std::memory_order_acquire); }
+
+    /**
+     * Replaces the copy seen by the readers
+     * @param value the new value
+     */
+    void publish(const T &value) {
+        const T* old = current.exchange(new T(value), std::memory_order_acq_rel);
+        Epoch::retire(const_cast<T*>(old));
+    }
+
+private:
+    std::atomic<const T*> current;
+};
+
+
+#endif //SPACE_INVADERS_PUBLISHED_H
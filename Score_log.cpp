@@ -0,0 +1,276 @@
+//
+// Created by piotrek on 16.06.17.
+//
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Score_log.h"
+
+static const uint32_t INDEX_MAGIC = 0x53434f52; // "SCOR"
+static const uint32_t RECORD_MAGIC = 0x47414d45; // "GAME"
+static const uint32_t VERSION = 1;
+static const uint64_t INITIAL_RECORDS = 256;
+
+/**
+ * @return the lookup table of the CRC-32 polynomial
+ */
+static const uint32_t* crc32_table() {
+    static uint32_t table[256];
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+/**
+ * @return the CRC-32 of the given bytes
+ */
+static uint32_t crc32(const void* data, size_t length) {
+    static const uint32_t* table = crc32_table();
+    const unsigned char* bytes = (const unsigned char*) data;
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * Opens or creates the log and recovers the records written after the last intact index.
+ * When the file can't be opened the log stays closed and appending does nothing.
+ * @param path the path of the log file
+ */
+Score_log::Score_log(const char* path) {
+    map = nullptr;
+    mapped = 0;
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return;
+    flock(fd, LOCK_EX);
+    /// A new file, or one cut off in the middle of a record, is grown to hold whole records
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (fit((uint64_t) status.st_size) != (uint64_t) status.st_size &&
+            ftruncate(fd, (off_t) fit((uint64_t) status.st_size)) != 0) ||
+            fstat(fd, &status) != 0 || !remap((uint64_t) status.st_size)) {
+        flock(fd, LOCK_UN);
+        close(fd);
+        fd = -1;
+        return;
+    }
+    Index index;
+    const Index* last = current();
+    if (last != nullptr) {
+        index = *last;
+    } else {
+        std::memset(&index, 0, sizeof(index));
+        index.magic = INDEX_MAGIC;
+        index.version = VERSION;
+    }
+    uint32_t records = index.records;
+    recover(index);
+    if (last == nullptr || index.records != records) {
+        commit(index);
+    }
+    flock(fd, LOCK_UN);
+}
+
+Score_log::~Score_log() {
+    if (map != nullptr) {
+        munmap(map, mapped);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+/**
+ * Appends the result of a game, growing the file when it is full
+ * @param points the final score
+ * @param big_ships_destroyed the number of bombers destroyed
+ * @param small_ships_destroyed the number of small fighters destroyed
+ * @return true if the record was written
+ */
+bool Score_log::append(int points, int big_ships_destroyed, int small_ships_destroyed) {
+    if (fd < 0) return false;
+    flock(fd, LOCK_EX);
+    /// Another process may have grown the file since it was mapped
+    struct stat status;
+    if (fstat(fd, &status) != 0 || ((uint64_t) status.st_size != mapped && !remap((uint64_t) status.st_size))) {
+        flock(fd, LOCK_UN);
+        return false;
+    }
+    const Index* last = current();
+    if (last == nullptr) {
+        flock(fd, LOCK_UN);
+        return false;
+    }
+    Index index = *last;
+    recover(index);
+    uint64_t end = HEADER_SIZE + (index.records + 1ul) * sizeof(Record);
+    if (end > mapped) {
+        uint64_t length = fit(std::max(end, HEADER_SIZE + (mapped - HEADER_SIZE) * 2));
+        if (ftruncate(fd, (off_t) length) != 0 || !remap(length)) {
+            flock(fd, LOCK_UN);
+            return false;
+        }
+    }
+    Record* written = record(index.records);
+    written->time = (int64_t) std::time(nullptr);
+    written->magic = RECORD_MAGIC;
+    written->number = index.records;
+    written->points = points;
+    written->big_ships_destroyed = big_ships_destroyed;
+    written->small_ships_destroyed = small_ships_destroyed;
+    written->checksum = crc32(written, offsetof(Record, checksum));
+
+    Score score = { written->time, points, big_ships_destroyed, small_ships_destroyed, index.records };
+    push(index, score);
+    index.records++;
+    commit(index);
+    flock(fd, LOCK_UN);
+    return true;
+}
+
+/**
+ * Reads the leaderboard straight from the mapped index
+ * @return the best scores, the highest first
+ */
+std::vector<Score_log::Score> Score_log::top() const {
+    std::vector<Score> scores;
+    const Index* index = fd >= 0 ? current() : nullptr;
+    if (index != nullptr) {
+        scores.assign(index->heap, index->heap + index->count);
+        std::sort(scores.begin(), scores.end(), [](const Score &a, const Score &b) {
+            return a.points != b.points ? a.points > b.points : a.record < b.record;
+        });
+    }
+    return scores;
+}
+
+/**
+ * @return the number of records in the log
+ */
+uint32_t Score_log::size() const {
+    const Index* index = fd >= 0 ? current() : nullptr;
+    return index != nullptr ? index->records : 0;
+}
+
+Score_log::Index* Score_log::slot(int i) const {
+    return (Index*) (map + i * (HEADER_SIZE / 2));
+}
+
+/**
+ * @return the intact copy of the index with the higher sequence number, or nullptr if there is none
+ */
+const Score_log::Index* Score_log::current() const {
+    const Index* first = valid(slot(0)) ? slot(0) : nullptr;
+    const Index* second = valid(slot(1)) ? slot(1) : nullptr;
+    if (first == nullptr) return second;
+    if (second == nullptr) return first;
+    return first->sequence > second->sequence ? first : second;
+}
+
+Score_log::Record* Score_log::record(uint32_t number) const {
+    return (Record*) (map + HEADER_SIZE + number * sizeof(Record));
+}
+
+/**
+ * Maps the given length of the file, replacing the previous mapping
+ * @return false if the file couldn't be mapped
+ */
+bool Score_log::remap(uint64_t length) {
+    if (map != nullptr) {
+        munmap(map, mapped);
+        map = nullptr;
+        mapped = 0;
+    }
+    void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) return false;
+    map = (unsigned char*) address;
+    mapped = length;
+    return true;
+}
+
+/**
+ * @param length a length of the file
+ * @return the shortest length not below the given one which holds the header, at least
+ *         INITIAL_RECORDS records and no part of a record
+ */
+uint64_t Score_log::fit(uint64_t length) {
+    uint64_t records = length > HEADER_SIZE ? (length - HEADER_SIZE + sizeof(Record) - 1) / sizeof(Record) : 0;
+    return HEADER_SIZE + std::max(records, INITIAL_RECORDS) * sizeof(Record);
+}
+
+/**
+ * Adds the intact records that follow the end of the index to it. The first torn record
+ * ends the log, the next append overwrites it.
+ * @param index the index to bring up to date
+ */
+void Score_log::recover(Index &index) {
+    while (HEADER_SIZE + (index.records + 1ul) * sizeof(Record) <= mapped && valid(record(index.records), index.records)) {
+        const Record* found = record(index.records);
+        Score score = { found->time, found->points, found->big_ships_destroyed, found->small_ships_destroyed, index.records };
+        push(index, score);
+        index.records++;
+    }
+}
+
+/**
+ * Writes the index into the slot not holding the current copy
+ * @param index the new index
+ */
+void Score_log::commit(Index &index) {
+    const Index* last = current();
+    index.sequence = last != nullptr ? last->sequence + 1 : 1;
+    index.checksum = crc32(&index, offsetof(Index, checksum));
+    std::memcpy(slot(int(index.sequence % 2)), &index, sizeof(Index));
+}
+
+/**
+ * Keeps the best TOP scores in the min-heap, the worst of them at the root
+ * @param index the index holding the heap
+ * @param score the new score
+ */
+void Score_log::push(Index &index, const Score &score) {
+    Score* heap = index.heap;
+    if (index.count < TOP) {
+        int i = index.count++;
+        while (i > 0 && heap[(i - 1) / 2].points > score.points) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = score;
+        return;
+    }
+    if (score.points <= heap[0].points) return;
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= TOP) break;
+        if (child + 1 < TOP && heap[child + 1].points < heap[child].points) child++;
+        if (heap[child].points >= score.points) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = score;
+}
+
+bool Score_log::valid(const Index* index) {
+    return index->magic == INDEX_MAGIC && index->version == VERSION && index->count <= TOP &&
+           index->checksum == crc32(index, offsetof(Index, checksum));
+}
+
+bool Score_log::valid(const Record* record, uint32_t number) {
+    return record->magic == RECORD_MAGIC && record->number == number &&
+           record->checksum == crc32(record, offsetof(Record, checksum));
+}
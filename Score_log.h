@@ -0,0 +1,92 @@
+//
+// Created by piotrek on 16.06.17.
+//
+
+#ifndef SPACE_INVADERS_SCORE_LOG_H
+#define SPACE_INVADERS_SCORE_LOG_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Persistent record of every finished game. The file is memory mapped and only ever appended to.
+ * The first page holds two copies of the index: the offset of the end of the log and a min-heap
+ * of the best scores. They are written alternately with increasing sequence numbers, so a crash
+ * in the middle of an update leaves the other copy intact. Every record carries a checksum and
+ * opening the log recovers the records appended after the last intact index, stopping at the first
+ * torn one. Appends from several processes are serialized with an advisory file lock.
+ */
+class Score_log {
+public:
+    static const int TOP = 16;
+
+    struct Score {
+        int64_t time; // seconds since the epoch
+        int32_t points;
+        int32_t big_ships_destroyed;
+        int32_t small_ships_destroyed;
+        uint32_t record; // the number of the record in the log
+    };
+
+    explicit Score_log(const char* path);
+
+    ~Score_log();
+
+    bool isOpen() const { return fd >= 0; }
+
+    bool append(int points, int big_ships_destroyed, int small_ships_destroyed);
+
+    std::vector<Score> top() const;
+
+    uint32_t size() const;
+
+private:
+    struct Record {
+        int64_t time;
+        uint32_t magic;
+        uint32_t number;
+        int32_t points;
+        int32_t big_ships_destroyed;
+        int32_t small_ships_destroyed;
+        uint32_t checksum;
+    };
+
+    struct Index {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sequence;
+        uint32_t records;
+        uint32_t count; // the number of scores in the heap
+        Score heap[TOP]; // min-heap on points
+        uint32_t checksum;
+    };
+
+    static const uint64_t HEADER_SIZE = 4096;
+
+    int fd;
+    unsigned char* map;
+    uint64_t mapped;
+
+    Index* slot(int i) const;
+
+    const Index* current() const;
+
+    Record* record(uint32_t number) const;
+
+    bool remap(uint64_t length);
+
+    static uint64_t fit(uint64_t length);
+
+    void recover(Index &index);
+
+    void commit(Index &index);
+
+    static void push(Index &index, const Score &score);
+
+    static bool valid(const Index* index);
+
+    static bool valid(const Record* record, uint32_t number);
+};
+
+
+#endif //SPACE_INVADERS_SCORE_LOG_H
@@ -0,0 +1,68 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include "Script_scheduler.h"
+#include "Formation.h"
+#include "Spatial_index.h"
+
+/**
+ * @param _turn_dice the dice result above which the formations turn at random
+ */
+Script_scheduler::Script_scheduler(int _turn_dice) : turn_dice(_turn_dice) {}
+
+/**
+ * Resumes every formation's script once. A formation seen for the first time starts
+ * a script picked at random. With 1% probability a member of a bigger formation breaks
+ * away and dives on its own, starting with the next tick.
+ * @param formations the formations' vector
+ * @param host the game
+ * @param index the index of the formations, nullptr when the game keeps none
+ */
+void Script_scheduler::resume(std::vector<Formation*> &formations, Script_host &host, Spatial_index* index) {
+    unsigned long count = formations.size();
+    for (unsigned long i = 0; i < count; i++) {
+        Formation* formation = formations[i];
+        if (formation->size() > 1 && host.dice() > 99) {
+            Formation* single = formation->breakFormation(host.dice());
+            single->setScript(acquire(Enemy_script::DIVE));
+            if (index != nullptr) {
+                index->insert(single);
+            }
+            formations.push_back(single);
+        }
+        if (formation->getScript() < 0) {
+            formation->setScript(acquire(Enemy_script::Pattern(host.dice() % Enemy_script::PATTERNS)));
+        }
+        Enemy_script::resume(frames[formation->getScript()], *formation, host);
+    }
+}
+
+/**
+ * Returns the formation's frame to the pool
+ * @param formation the retired formation
+ */
+void Script_scheduler::release(Formation* formation) {
+    if (formation->getScript() >= 0) {
+        free_frames.push_back(formation->getScript());
+        formation->setScript(-1);
+    }
+}
+
+/**
+ * Takes a frame from the pool, growing the pool when all of them are running
+ * @param pattern the script to start
+ * @return the number of the frame
+ */
+int Script_scheduler::acquire(Enemy_script::Pattern pattern) {
+    int frame;
+    if (free_frames.empty()) {
+        frame = (int) frames.size();
+        frames.emplace_back();
+    } else {
+        frame = free_frames.back();
+        free_frames.pop_back();
+    }
+    Enemy_script::start(frames[frame], pattern, turn_dice);
+    return frame;
+}
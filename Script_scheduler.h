@@ -0,0 +1,39 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_SCRIPT_SCHEDULER_H
+#define SPACE_INVADERS_SCRIPT_SCHEDULER_H
+
+#include <vector>
+#include "Enemy_script.h"
+
+class Formation;
+class Spatial_index;
+
+/**
+ * Runs a script for every formation of a kind. The frames live in a pool, a formation
+ * keeps the number of its frame and the frames of the retired formations are reused,
+ * so starting a script costs no allocation once the pool has grown to the crowd.
+ * Used with the mutex guarding the formations locked.
+ */
+class Script_scheduler {
+public:
+    explicit Script_scheduler(int _turn_dice);
+
+    void resume(std::vector<Formation*> &formations, Script_host &host, Spatial_index* index);
+
+    void release(Formation* formation);
+
+    unsigned long running() const { return frames.size() - free_frames.size(); }
+
+private:
+    int turn_dice;
+    std::vector<Enemy_script::Frame> frames;
+    std::vector<int> free_frames;
+
+    int acquire(Enemy_script::Pattern pattern);
+};
+
+
+#endif //SPACE_INVADERS_SCRIPT_SCHEDULER_H
@@ -3,23 +3,119 @@
 //
 
 #include "Shield.h"
+
+static_assert(Shield::COLUMNS < 64, "A shield row has to fit in one machine word");
+
 Shield::Shield(int _pos_x, int _pos_y, int _min_x, int _max_x, int _min_y, int _max_y)
-        : Game_actor(_pos_x, _pos_y, 20, 3, _min_x, _max_x, _min_y, _max_y){
-    hit_points = 200;
+        : Game_actor(_pos_x, _pos_y, COLUMNS, ROWS, _min_x, _max_x, _min_y, _max_y){
+    for (int i = 0; i < ROWS; i++) {
+        cells[i].store((uint64_t(1) << COLUMNS) - 1, std::memory_order_relaxed);
+    }
+    recount();
+}
+
+/**
+ * Copies the shield together with its standing cells
+ */
+Shield::Shield(const Shield &other) : Game_actor(other) {
+    for (int i = 0; i < ROWS; i++) {
+        cells[i].store(other.getCells(i), std::memory_order_relaxed);
+    }
 }
-/** Shield's shape
+/** Shield's shape, every '#' is a single destructible cell
  * ####################
  * ####################
  * ####################
  */
-void Shield::drawActor() {
+void Shield::drawActor(const Viewport &view) {
+    int x = pos_x - view.getOrigin_x();
+    int y = pos_y - view.getOrigin_y();
     if(!done) {
-        for (int i = 0; i < 3; i++) {
-            if (i == 0 && hit_points <= 100) continue;
-            if (i == 1 && hit_points <= 50) continue;
-            for (int j=0; j < 20; j++) {
-                mvprintw(pos_y+i, pos_x+j, "#");
+        for (int i = 0; i < ROWS; i++) {
+            uint64_t row = getCells(i);
+            while (row) {
+                int j = __builtin_ctzll(row);
+                mvprintw(y+i, x+j, "#");
+                row &= row - 1;
             }
         }
     }
 }
+
+/**
+ * Builds the bit mask of the shield columns covered by the span [x, x + w)
+ * @param x the first column of the span on the screen
+ * @param w the number of columns in the span
+ * @return the mask, 0 if the span misses the shield
+ */
+uint64_t Shield::columnsMask(int x, int w) const {
+    int lo = x - pos_x;
+    int hi = lo + w;
+    if (lo < 0) lo = 0;
+    if (hi > COLUMNS) hi = COLUMNS;
+    if (lo >= hi) return 0;
+    return ((uint64_t(1) << (hi - lo)) - 1) << lo;
+}
+
+/**
+ * Checks if the actor touches any of the standing cells. Reads only the rows,
+ * so it may be called by any thread while the rendering thread erodes the shield.
+ * @param actor the actor to be checked
+ * @return true if at least one cell under the actor is still standing
+ */
+bool Shield::overlaps(Game_actor* actor) const {
+    uint64_t mask = columnsMask(actor->getPos_x(), actor->getWidth());
+    if (!mask) return false;
+    int first = actor->getPos_y() - pos_y;
+    int last = first + actor->getHeight();
+    if (first < 0) first = 0;
+    if (last > ROWS) last = ROWS;
+    for (int i = first; i < last; i++) {
+        if (getCells(i) & mask) return true;
+    }
+    return false;
+}
+
+/**
+ * Resolves a bullet hit. The first row met by the bullet (top-down for bullets going DOWN,
+ * bottom-up for the ones going UP) loses the cells under the bullet, widened by blast cells
+ * on both sides. The blast also digs blast rows deeper into the shield.
+ * @param bullet the bullet to be checked
+ * @param blast the radius of the crater in cells, 0 for small bullets
+ * @return true if the bullet hit the shield
+ */
+bool Shield::erode(Game_actor* bullet, int blast) {
+    if (done) return false;
+    uint64_t mask = columnsMask(bullet->getPos_x(), bullet->getWidth());
+    if (!mask) return false;
+    int first = bullet->getPos_y() - pos_y;
+    int last = first + bullet->getHeight();
+    if (first < 0) first = 0;
+    if (last > ROWS) last = ROWS;
+    if (first >= last) return false;
+
+    int step = bullet->move_direction == UP ? -1 : 1;
+    int i = step > 0 ? first : last - 1;
+    for (; i >= first && i < last; i += step) {
+        if (getCells(i) & mask) break;
+    }
+    if (i < first || i >= last) return false;
+
+    uint64_t crater = columnsMask(bullet->getPos_x() - blast, bullet->getWidth() + 2 * blast);
+    for (int depth = 0; depth <= blast && i >= 0 && i < ROWS; depth++, i += step) {
+        cells[i].store(getCells(i) & ~crater, std::memory_order_relaxed);
+    }
+    recount();
+    return true;
+}
+
+/**
+ * Hit points of the shield are the number of the cells still standing
+ */
+void Shield::recount() {
+    hit_points = 0;
+    for (int i = 0; i < ROWS; i++) {
+        hit_points += __builtin_popcountll(getCells(i));
+    }
+    done = hit_points == 0;
+}
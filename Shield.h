@@ -6,12 +6,37 @@
 #define SPACE_INVADERS_SHIELD_H
 
 #include <ncurses.h>
+#include <atomic>
+#include <cstdint>
 #include "Game_actor.h"
+#include "Memory_stats.h"
 
-class Shield : public Game_actor{
+/**
+ * Destructible bunker. Every row of the shield is kept as a single machine word,
+ * where bit i set means that the cell in column pos_x + i is still standing.
+ * Collisions are resolved by AND-ing the rows with the column mask of the other actor.
+ * Only the rendering thread erodes the rows, while the enemies' and the input threads read them,
+ * so the rows are atomic words, accessed relaxed: a reader sees every row either before or after a hit.
+ */
+class Shield : public Game_actor, public Memory_counted<Memory_stats::SHIELD> {
 public:
+    static const int ROWS = 3;
+    static const int COLUMNS = 20;
+
     Shield(int _pos_x, int _pos_y, int _min_x, int _max_x, int _min_y, int _max_y);
-    void drawActor();
+    Shield(const Shield &other);
+    void drawActor(const Viewport &view);
+
+    bool overlaps(Game_actor* actor) const;
+    bool erode(Game_actor* bullet, int blast);
+
+    uint64_t getCells(int row) const { return cells[row].load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> cells[ROWS];
+
+    uint64_t columnsMask(int x, int w) const;
+    void recount();
 };
 
 
@@ -0,0 +1,101 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#include <algorithm>
+#include "Shield_wall.h"
+
+/**
+ * Creates the shields, evenly spread along the row above the player
+ * @param count the number of shields wanted, fewer are created if they don't fit
+ * @param _columns the width of the area
+ * @param _rows the height of the area
+ */
+Shield_wall::Shield_wall(int count, int _columns, int _rows) {
+    count = std::max(1, std::min(count, _columns / (Shield::COLUMNS + 4)));
+    stride = std::max(1, _columns / count);
+    top = _rows - 7;
+    for (int i = 0; i < count; i++) {
+        int x = i * stride + (stride - Shield::COLUMNS) / 2;
+        shields.push_back(new Shield(x, top, 0, _columns, 0, _rows));
+    }
+}
+
+/**
+ * Copies the wall together with the shields
+ */
+Shield_wall::Shield_wall(const Shield_wall &other) {
+    top = other.top;
+    stride = other.stride;
+    for (Shield* shield : other.shields) {
+        shields.push_back(new Shield(*shield));
+    }
+}
+
+Shield_wall::~Shield_wall() {
+    for (Shield* shield : shields) {
+        delete shield;
+    }
+}
+
+/**
+ * Draws the shields inside the viewport, found by the slot lookup
+ * instead of checking all of them.
+ * @param view the viewport
+ */
+void Shield_wall::draw(const Viewport &view) {
+    int first = view.getOrigin_x() / stride;
+    int last = (view.getOrigin_x() + view.getColumns()) / stride;
+    for (int i = std::max(0, first); i <= last && i < int(shields.size()); i++) {
+        if (view.isVisible(shields[i])) {
+            shields[i]->drawActor(view);
+        }
+    }
+}
+
+/**
+ * Finds the shield whose slot contains the given column
+ * @param x the column
+ * @return the shield or nullptr if there is none
+ */
+Shield* Shield_wall::at(int x) const {
+    if (x < 0) return nullptr;
+    unsigned long i = (unsigned long) (x / stride);
+    return i < shields.size() ? shields[i] : nullptr;
+}
+
+/**
+ * Checks if the actor touches a standing part of any shield. Only the shields
+ * in the slots under the actor's columns are checked.
+ * @param actor the actor to be checked
+ */
+bool Shield_wall::overlaps(Game_actor* actor) const {
+    int y = actor->getPos_y();
+    if (y + actor->getHeight() <= top || y > getBottom()) {
+        return false;
+    }
+    int first = std::max(actor->getPos_x(), 0) / stride;
+    int last = std::min((actor->getPos_x() + actor->getWidth() - 1) / stride, int(shields.size()) - 1);
+    for (int i = first; i <= last; i++) {
+        if (shields[i]->overlaps(actor)) return true;
+    }
+    return false;
+}
+
+/**
+ * Resolves the bullet against the shields' bitmaps. The row band check and the slot lookup
+ * reduce it to at most two shields, each resolved with a few word operations.
+ * @param bullet the bullet to be checked
+ * @param blast the crater radius passed to Shield::erode
+ * @return true if the bullet hit a shield and has to be removed
+ */
+bool Shield_wall::erode(Game_actor* bullet, int blast) {
+    int y = bullet->getPos_y();
+    if (y + bullet->getHeight() <= top || y > getBottom()) {
+        return false;
+    }
+    Shield* left = at(bullet->getPos_x());
+    if (left != nullptr && left->erode(bullet, blast)) return true;
+    Shield* right = at(bullet->getPos_x() + bullet->getWidth() - 1);
+    return right != nullptr && right != left && right->erode(bullet, blast);
+}
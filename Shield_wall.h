@@ -0,0 +1,44 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#ifndef SPACE_INVADERS_SHIELD_WALL_H
+#define SPACE_INVADERS_SHIELD_WALL_H
+
+#include <vector>
+#include "Shield.h"
+#include "Viewport.h"
+
+/**
+ * The row of shields above the player. The shields are evenly spaced in slots of equal width,
+ * so the shield under any column is found with a single division.
+ */
+class Shield_wall {
+    std::vector<Shield*> shields;
+    int top; // top row of the shields
+    int stride; // columns between the beginnings of the neighbouring shields' slots
+
+public:
+    Shield_wall(int count, int _columns, int _rows);
+
+    Shield_wall(const Shield_wall &other);
+
+    ~Shield_wall();
+
+    void draw(const Viewport &view);
+
+    Shield* at(int x) const;
+
+    bool overlaps(Game_actor* actor) const;
+
+    bool erode(Game_actor* bullet, int blast);
+
+    int getTop() const { return top; }
+
+    int getBottom() const { return top + Shield::ROWS - 1; }
+
+    const std::vector<Shield*> &getShields() const { return shields; }
+};
+
+
+#endif //SPACE_INVADERS_SHIELD_WALL_H
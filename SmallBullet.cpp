@@ -5,9 +5,20 @@
 #include "SmallBullet.h"
 
 SmallBullet::SmallBullet(short _pos_x, short _pos_y, int _min_x, int _max_x, int _min_y, int _max_y)
-    : Game_actor(_pos_x, _pos_y, 1, 1, _min_x, _max_x, _min_y, _max_y){
+    : Bullet(_pos_x, _pos_y, 1, 1, _min_x, _max_x, _min_y, _max_y){
 }
 
-void SmallBullet::drawActor() {
-    mvprintw(pos_y, pos_x, "*");
+void SmallBullet::drawActor(const Viewport &view) {
+    int x = pos_x - view.getOrigin_x();
+    int y = pos_y - view.getOrigin_y();
+    mvprintw(y, x, "*");
+}
+
+/**
+ * A streak half a cell long and a dot wide
+ */
+void SmallBullet::drawDots(const Viewport &view, Braille_layer &layer, long tick, short color) {
+    int x = (pos_x - view.getOrigin_x()) * Braille_layer::DOT_COLUMNS;
+    int y = dotRowAt(tick, Braille_layer::DOT_ROWS) - view.getOrigin_y() * Braille_layer::DOT_ROWS;
+    layer.column(x, y, Braille_layer::DOT_ROWS / 2, color);
 }
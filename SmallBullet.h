@@ -6,13 +6,16 @@
 #define SPACE_INVADERS_BULLET_H
 
 #include <ncurses.h>
-#include "Game_actor.h"
+#include "Bullet.h"
+#include "Memory_stats.h"
 
-class SmallBullet : public Game_actor{
+class SmallBullet : public Bullet, public Memory_counted<Memory_stats::SMALL_BULLET> {
 
 public:
     SmallBullet(short _pos_x, short _pos_y, int _min_x, int _max_x, int _min_y, int _max_y);
-    void drawActor();
+    void drawActor(const Viewport &view);
+    void drawDots(const Viewport &view, Braille_layer &layer, long tick, short color);
+    Bullet* clone() const { return new SmallBullet(*this); }
 };
 
 
@@ -0,0 +1,90 @@
+//
+// Created by piotrek on 10.06.17.
+//
+
+#include <algorithm>
+#include "Spatial_index.h"
+
+/**
+ * Constructs an empty index covering the whole world
+ * @param _world_columns the width of the world
+ * @param _world_rows the height of the world
+ * @param _bucket_columns the width of a bucket
+ * @param _bucket_rows the height of a bucket
+ */
+Spatial_index::Spatial_index(int _world_columns, int _world_rows, int _bucket_columns, int _bucket_rows) {
+    bucket_columns = _bucket_columns;
+    bucket_rows = _bucket_rows;
+    columns = _world_columns / bucket_columns + 1;
+    rows = _world_rows / bucket_rows + 1;
+    reach_columns = 0;
+    reach_rows = 0;
+    buckets.resize((unsigned long) (columns * rows));
+}
+
+/**
+ * Finds the bucket of the actor's top left corner. Actors outside of the world
+ * (e.g. bullets which have just flown away) are kept in the border buckets.
+ */
+int Spatial_index::bucketOf(Game_actor* actor) const {
+    int c = actor->getPos_x() / bucket_columns;
+    int r = actor->getPos_y() / bucket_rows;
+    c = std::max(0, std::min(c, columns - 1));
+    r = std::max(0, std::min(r, rows - 1));
+    return r * columns + c;
+}
+
+/**
+ * Adds the actor to the index. From now on the actor keeps the index up to date when it moves.
+ * @param actor the actor to be added
+ */
+void Spatial_index::insert(Game_actor* actor) {
+    mutex.lock();
+    reach_columns = std::max(reach_columns, actor->getWidth());
+    reach_rows = std::max(reach_rows, actor->getHeight());
+    actor->index = this;
+    actor->index_bucket = bucketOf(actor);
+    buckets[actor->index_bucket].push_back(actor);
+    mutex.unlock();
+}
+
+/**
+ * Removes the actor from the index
+ * @param actor the actor to be removed
+ */
+void Spatial_index::remove(Game_actor* actor) {
+    mutex.lock();
+    if (actor->index_bucket >= 0) {
+        std::vector<Game_actor*> &bucket = buckets[actor->index_bucket];
+        std::vector<Game_actor*>::iterator it = std::find(bucket.begin(), bucket.end(), actor);
+        if (it != bucket.end()) {
+            *it = bucket.back();
+            bucket.pop_back();
+        }
+    }
+    actor->index = nullptr;
+    actor->index_bucket = -1;
+    mutex.unlock();
+}
+
+/**
+ * Moves the actor to its new bucket. Called after every move, but it only locks
+ * the index when the actor has crossed the border of its bucket.
+ * @param actor the actor which has moved
+ */
+void Spatial_index::relocate(Game_actor* actor) {
+    int bucket = bucketOf(actor);
+    if (bucket == actor->index_bucket) return;
+    mutex.lock();
+    if (actor->index_bucket >= 0) {
+        std::vector<Game_actor*> &old_bucket = buckets[actor->index_bucket];
+        std::vector<Game_actor*>::iterator it = std::find(old_bucket.begin(), old_bucket.end(), actor);
+        if (it != old_bucket.end()) {
+            *it = old_bucket.back();
+            old_bucket.pop_back();
+        }
+        actor->index_bucket = bucket;
+        buckets[bucket].push_back(actor);
+    }
+    mutex.unlock();
+}
@@ -0,0 +1,91 @@
+//
+// Created by piotrek on 10.06.17.
+//
+
+#ifndef SPACE_INVADERS_SPATIAL_INDEX_H
+#define SPACE_INVADERS_SPATIAL_INDEX_H
+
+#include <vector>
+#include <mutex>
+#include "Game_actor.h"
+#include "Viewport.h"
+
+/**
+ * Uniform grid over the world. Every actor is kept in the bucket of its top left corner
+ * and moved to another bucket only when it crosses the bucket border, so drawing can
+ * visit just the buckets under the viewport instead of all the actors.
+ * Actors moving only vertically can be kept in column buckets as high as the world.
+ */
+class Spatial_index {
+public:
+    static const int BUCKET_COLUMNS = 32;
+    static const int BUCKET_ROWS = 4;
+
+    Spatial_index(int _world_columns, int _world_rows,
+                  int _bucket_columns = BUCKET_COLUMNS, int _bucket_rows = BUCKET_ROWS);
+
+    void insert(Game_actor* actor);
+
+    void remove(Game_actor* actor);
+
+    void relocate(Game_actor* actor);
+
+    /**
+     * Calls f for every actor which is at least partially inside the viewport.
+     * @param view the viewport
+     * @param f the function to be called with Game_actor*
+     */
+    template <typename F>
+    void forEachVisible(const Viewport &view, F f) {
+        forEachNear(view, [&view, &f](Game_actor* actor) {
+            if (view.isVisible(actor)) {
+                f(actor);
+            }
+        });
+    }
+
+    /**
+     * Calls f for every actor which is not done and is kept in the buckets under the viewport,
+     * extended left and up by the size of the biggest actor in the index.
+     * @param view the viewport
+     * @param f the function to be called with Game_actor*
+     */
+    template <typename F>
+    void forEachNear(const Viewport &view, F f) {
+        int first_column = (view.getOrigin_x() - reach_columns) / bucket_columns;
+        int last_column = (view.getOrigin_x() + view.getColumns()) / bucket_columns;
+        int first_row = (view.getOrigin_y() - reach_rows) / bucket_rows;
+        int last_row = (view.getOrigin_y() + view.getRows()) / bucket_rows;
+        if (first_column < 0) first_column = 0;
+        if (first_row < 0) first_row = 0;
+        if (last_column >= columns) last_column = columns - 1;
+        if (last_row >= rows) last_row = rows - 1;
+
+        mutex.lock();
+        for (int r = first_row; r <= last_row; r++) {
+            for (int c = first_column; c <= last_column; c++) {
+                for (Game_actor* actor : buckets[r * columns + c]) {
+                    if (!actor->isDone()) {
+                        f(actor);
+                    }
+                }
+            }
+        }
+        mutex.unlock();
+    }
+
+private:
+    int bucket_columns;
+    int bucket_rows;
+    int columns;
+    int rows;
+    int reach_columns; // the width of the widest actor ever inserted
+    int reach_rows; // the height of the highest actor ever inserted
+    std::vector<std::vector<Game_actor*>> buckets;
+    std::mutex mutex;
+
+    int bucketOf(Game_actor* actor) const;
+};
+
+
+#endif //SPACE_INVADERS_SPATIAL_INDEX_H
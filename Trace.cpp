@@ -0,0 +1,214 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include "Trace.h"
+
+/**
+ * One recorded event. Slices keep their duration in value, counters their count.
+ */
+struct Trace_event {
+    const char* name;
+    const char* category;
+    int64_t start; // nanoseconds since the trace's epoch
+    int64_t value;
+    int64_t wait; // how long the thread waited before the slice, for the locks' slices
+    char phase; // 'X' slice, 'C' counter, 'i' instant
+};
+
+/**
+ * The events of one thread. Only the owning thread writes it, the head is atomic
+ * so the events can be written out while the thread is still running.
+ */
+struct Trace_ring {
+    const char* thread_name;
+    int thread;
+    std::atomic<uint64_t> head;
+    Trace_event events[Trace::RING];
+};
+
+std::atomic_bool Trace::enabled(false);
+
+/// Rings of all the threads, registered once per thread and kept until the trace is written,
+/// so the threads which have already finished are still written out
+static std::mutex registry_mutex;
+static std::vector<Trace_ring*> registry;
+static const char* path = nullptr;
+static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+static thread_local const char* thread_name = nullptr;
+static thread_local Trace_ring* thread_ring = nullptr;
+
+static Trace_ring* ring() {
+    if (thread_ring == nullptr) {
+        thread_ring = new Trace_ring();
+        thread_ring->thread_name = thread_name;
+        thread_ring->head = 0;
+        registry_mutex.lock();
+        thread_ring->thread = int(registry.size()) + 1;
+        registry.push_back(thread_ring);
+        registry_mutex.unlock();
+    }
+    return thread_ring;
+}
+
+static void record(const char* name, const char* category, char phase, int64_t start, int64_t value, int64_t wait) {
+    Trace_ring* events = ring();
+    uint64_t head = events->head.load(std::memory_order_relaxed);
+    events->events[head % Trace::RING] = { name, category, start, value, wait, phase };
+    events->head.store(head + 1, std::memory_order_release);
+}
+
+/**
+ * Starts the slice, if the tracing is on
+ * @param _name the slice's name
+ * @param _category the slice's category
+ */
+Trace::Scope::Scope(const char* _name, const char* _category)
+        : name(_name), category(_category), start(isEnabled() ? clock() : -1) {}
+
+Trace::Scope::~Scope() {
+    if (start >= 0) {
+        slice(name, category, start);
+    }
+}
+
+/**
+ * Switches the tracing on, the events will be written to the file at the end of the game
+ * @param _path the Chrome trace file
+ */
+void Trace::open(const char* _path) {
+    path = _path;
+    enabled = true;
+}
+
+/**
+ * Switches the tracing on or off. Does nothing unless the trace was opened.
+ * @return true if the tracing is on now
+ */
+bool Trace::toggle() {
+    if (path == nullptr) return false;
+    enabled = !enabled;
+    return enabled;
+}
+
+/**
+ * @return nanoseconds since the trace's epoch
+ */
+int64_t Trace::clock() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+/**
+ * Names the calling thread in the timeline
+ * @param name the thread's name, a string literal
+ */
+void Trace::nameThread(const char* name) {
+    thread_name = name;
+    if (thread_ring != nullptr) {
+        thread_ring->thread_name = name;
+    }
+}
+
+/**
+ * Records a slice ending now
+ * @param name the slice's name, a string literal
+ * @param category the slice's category, a string literal
+ * @param start when the slice started, from clock()
+ * @param wait how long the thread waited before the slice, in nanoseconds, shown when positive
+ */
+void Trace::slice(const char* name, const char* category, int64_t start, int64_t wait) {
+    if (!isEnabled()) return;
+    record(name, category, 'X', start, clock() - start, wait);
+}
+
+/**
+ * Records the current value of a counter
+ * @param name the counter's name, a string literal
+ * @param value the value
+ */
+void Trace::counter(const char* name, long value) {
+    if (!isEnabled()) return;
+    record(name, "count", 'C', clock(), value, 0);
+}
+
+/**
+ * Records a moment marked across all the threads
+ * @param name the moment's name, a string literal
+ */
+void Trace::instant(const char* name) {
+    if (!isEnabled()) return;
+    record(name, "mark", 'i', clock(), 0, 0);
+}
+
+/**
+ * Writes the latest events of every thread to the trace file as Chrome trace events and frees
+ * the threads' rings. Called at the end of the game, once the other threads are joined.
+ * @param out the stream for the summary
+ * @return true if the trace was written
+ */
+bool Trace::write(std::ostream &out) {
+    if (path == nullptr) return false;
+    std::FILE* file = std::fopen(path, "w");
+    if (file == nullptr) {
+        out << "trace: can't write " << path << std::endl;
+        release();
+        return false;
+    }
+    unsigned long written = 0;
+    unsigned long lost = 0;
+    std::fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    std::fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"Space Invaders\"}}");
+    registry_mutex.lock();
+    for (Trace_ring* events : registry) {
+        std::fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                "\"args\": {\"name\": \"%s\"}}", events->thread, events->thread_name != nullptr ? events->thread_name : "thread");
+        uint64_t head = events->head.load(std::memory_order_acquire);
+        uint64_t first = head > RING ? head - RING : 0;
+        lost += first;
+        for (uint64_t i = first; i < head; i++) {
+            const Trace_event &event = events->events[i % RING];
+            std::fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d",
+                         event.name, event.category, event.phase, event.start / 1000.0, events->thread);
+            if (event.phase == 'X') {
+                std::fprintf(file, ", \"dur\": %.3f", event.value / 1000.0);
+                if (event.wait > 0) {
+                    std::fprintf(file, ", \"args\": {\"wait_us\": %.3f}", event.wait / 1000.0);
+                }
+            } else if (event.phase == 'C') {
+                std::fprintf(file, ", \"args\": {\"value\": %lld}", (long long) event.value);
+            } else {
+                std::fprintf(file, ", \"s\": \"g\"");
+            }
+            std::fprintf(file, "}");
+            written++;
+        }
+    }
+    unsigned long threads = registry.size();
+    registry_mutex.unlock();
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+    out << "trace: " << written << " events of " << threads << " threads written to " << path
+        << ", " << lost << " overwritten" << std::endl;
+    release();
+    return true;
+}
+
+/**
+ * Closes the trace and frees the rings of all the threads, none of which may record any more
+ */
+void Trace::release() {
+    enabled = false;
+    path = nullptr;
+    registry_mutex.lock();
+    for (Trace_ring* events : registry) {
+        delete events;
+    }
+    registry.clear();
+    registry_mutex.unlock();
+    thread_ring = nullptr;
+}
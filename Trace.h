@@ -0,0 +1,69 @@
+//
+// Created by piotrek on 19.06.17.
+//
+
+#ifndef SPACE_INVADERS_TRACE_H
+#define SPACE_INVADERS_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * The timeline of all the game's threads, written as Chrome trace events viewable in Perfetto.
+ * Every thread records its events into a ring of its own, allocated with its first event
+ * and freed when the trace is written, so recording takes no locks and a long session keeps
+ * the latest events of each thread. Slices are recorded when they end, with their start and
+ * duration, so the oldest ones can be overwritten without leaving unbalanced beginnings or ends.
+ * Tracing can be switched on and off while the game runs, a switched off tracer costs a relaxed
+ * load per event.
+ */
+class Trace {
+public:
+    static const unsigned long RING = 1 << 16; // events kept per thread
+
+    /**
+     * A slice lasting as long as the scope, recorded when the scope ends
+     */
+    class Scope {
+    public:
+        explicit Scope(const char* _name, const char* _category = "game");
+
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        const char* name;
+        const char* category;
+        int64_t start;
+    };
+
+    static void open(const char* _path);
+
+    static bool toggle();
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    static int64_t clock();
+
+    static void nameThread(const char* name);
+
+    static void slice(const char* name, const char* category, int64_t start, int64_t wait = 0);
+
+    static void counter(const char* name, long value);
+
+    static void instant(const char* name);
+
+    static bool write(std::ostream &out);
+
+private:
+    static std::atomic_bool enabled;
+
+    static void release();
+};
+
+
+#endif //SPACE_INVADERS_TRACE_H
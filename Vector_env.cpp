@@ -0,0 +1,55 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#include "Vector_env.h"
+
+/**
+ * Creates the worlds and their observations
+ * @param count the number of worlds
+ * @param _columns the width of every world
+ * @param _rows the height of every world
+ * @param seed the seed of the first world, the next worlds get the following seeds
+ */
+Vector_env::Vector_env(int count, int _columns, int _rows, unsigned int seed)
+        : cells(size_t(count) * size_t(_columns) * size_t(_rows)), hit_points(size_t(count)) {
+    columns = _columns;
+    rows = _rows;
+    for (int i = 0; i < count; i++) {
+        worlds.push_back(new World(columns, rows, seed + i));
+        observations.push_back(Observation(cells.data() + size_t(i) * columns * rows, &hit_points[i], columns, rows));
+        worlds[i]->observe(observations[i]);
+    }
+}
+
+Vector_env::~Vector_env() {
+    for (World* world : worlds) {
+        delete world;
+    }
+}
+
+/**
+ * Steps every world which is not over and writes its observation in place
+ * @param actions one action per world
+ * @return the observations of all the worlds
+ */
+const unsigned char* Vector_env::step(const Action* actions) {
+    for (unsigned long i = 0; i < worlds.size(); i++) {
+        if (!worlds[i]->isOver()) {
+            worlds[i]->step(actions[i]);
+            worlds[i]->observe(observations[i]);
+        }
+    }
+    return cells.data();
+}
+
+/**
+ * Starts a new game in the given world
+ * @param i the world
+ * @param seed the seed of the new game
+ */
+void Vector_env::reset(int i, unsigned int seed) {
+    delete worlds[i];
+    worlds[i] = new World(columns, rows, seed);
+    worlds[i]->observe(observations[i]);
+}
@@ -0,0 +1,47 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#ifndef SPACE_INVADERS_VECTOR_ENV_H
+#define SPACE_INVADERS_VECTOR_ENV_H
+
+#include <vector>
+#include "World.h"
+
+/**
+ * Many headless worlds stepped together. The observations of all the worlds live
+ * in one contiguous array, world after world, which is allocated once and written
+ * in place by every step.
+ */
+class Vector_env {
+public:
+    Vector_env(int count, int _columns, int _rows, unsigned int seed);
+
+    ~Vector_env();
+
+    const unsigned char* step(const Action* actions);
+
+    void reset(int i, unsigned int seed);
+
+    int size() const { return int(worlds.size()); }
+
+    const World &getWorld(int i) const { return *worlds[i]; }
+
+    const Observation &getObservation(int i) const { return observations[i]; }
+
+    /// [world][row][column] cell types of all the worlds
+    const unsigned char* getCells() const { return cells.data(); }
+
+    const int* getHit_points() const { return hit_points.data(); }
+
+private:
+    int columns;
+    int rows;
+    std::vector<World*> worlds;
+    std::vector<unsigned char> cells;
+    std::vector<int> hit_points;
+    std::vector<Observation> observations;
+};
+
+
+#endif //SPACE_INVADERS_VECTOR_ENV_H
@@ -0,0 +1,76 @@
+//
+// Created by piotrek on 10.06.17.
+//
+
+#include <algorithm>
+#include "Viewport.h"
+#include "Game_actor.h"
+
+/**
+ * Constructs the viewport in the top left corner of the world
+ * @param _columns the width of the terminal
+ * @param _rows the height of the terminal
+ * @param _world_columns the width of the whole world
+ * @param _world_rows the height of the whole world
+ */
+Viewport::Viewport(int _columns, int _rows, int _world_columns, int _world_rows) {
+    origin_x = 0;
+    origin_y = 0;
+    columns = _columns;
+    rows = _rows;
+    world_columns = _world_columns;
+    world_rows = _world_rows;
+}
+
+/**
+ * Moves the camera so the actor is in the middle of the screen,
+ * without showing anything outside of the world.
+ * @param actor the actor to be followed
+ */
+void Viewport::follow(const Game_actor &actor) {
+    int x = actor.getPos_x() + actor.getWidth() / 2 - columns / 2;
+    int y = actor.getPos_y() + actor.getHeight() / 2 - rows / 2;
+    if (x > world_columns - columns) x = world_columns - columns;
+    if (y > world_rows - rows) y = world_rows - rows;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    origin_x = x;
+    origin_y = y;
+}
+
+/**
+ * Changes the size of the viewport after the terminal has been resized.
+ * The world and the actors stay as they are, so it costs the same whatever is in the game.
+ * @param _columns the new width of the terminal
+ * @param _rows the new height of the terminal
+ */
+void Viewport::resize(int _columns, int _rows) {
+    columns = _columns;
+    rows = _rows;
+    if (origin_x > world_columns - columns) origin_x = std::max(0, world_columns - columns);
+    if (origin_y > world_rows - rows) origin_y = std::max(0, world_rows - rows);
+}
+
+/**
+ * Checks if any part of the actor is inside the viewport
+ * @param actor the actor to be checked
+ */
+bool Viewport::isVisible(Game_actor* actor) const {
+    return actor->getPos_x() + actor->getWidth() > origin_x
+           && actor->getPos_x() < origin_x + columns
+           && actor->getPos_y() + actor->getHeight() > origin_y
+           && actor->getPos_y() < origin_y + rows;
+}
+
+/**
+ * Creates a copy of the viewport with the origin moved by the given vector.
+ * Used to draw actors whose coordinates are relative to another actor.
+ * @param dx the change of the origin's x coordinate
+ * @param dy the change of the origin's y coordinate
+ */
+Viewport Viewport::shifted(int dx, int dy) const {
+    Viewport view = *this;
+    view.origin_x += dx;
+    view.origin_y += dy;
+    return view;
+}
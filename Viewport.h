@@ -0,0 +1,43 @@
+//
+// Created by piotrek on 10.06.17.
+//
+
+#ifndef SPACE_INVADERS_VIEWPORT_H
+#define SPACE_INVADERS_VIEWPORT_H
+
+class Game_actor;
+
+/**
+ * The part of the world which is currently shown in the terminal.
+ * World coordinates are translated to screen coordinates by subtracting the origin.
+ */
+class Viewport {
+    int origin_x;
+    int origin_y;
+    int columns;
+    int rows;
+    int world_columns;
+    int world_rows;
+
+public:
+    Viewport(int _columns, int _rows, int _world_columns, int _world_rows);
+
+    void follow(const Game_actor &actor);
+
+    void resize(int _columns, int _rows);
+
+    Viewport shifted(int dx, int dy) const;
+
+    bool isVisible(Game_actor* actor) const;
+
+    int getOrigin_x() const { return origin_x; }
+
+    int getOrigin_y() const { return origin_y; }
+
+    int getColumns() const { return columns; }
+
+    int getRows() const { return rows; }
+};
+
+
+#endif //SPACE_INVADERS_VIEWPORT_H
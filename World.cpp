@@ -0,0 +1,491 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#include <algorithm>
+#include <climits>
+#include <unordered_map>
+#include "World.h"
+#include "Game_rules.h"
+
+static const long frame_milis = frame_durtion.count();
+
+/**
+ * Creates the world with the players and the shields, the first enemies come with the first step
+ * @param _columns the width of the world
+ * @param _rows the height of the world
+ * @param seed the seed of the world's dice
+ * @param _players the number of players, evenly spread along the bottom row
+ */
+World::World(int _columns, int _rows, unsigned int seed, int _players)
+        : generator(seed), distribution(1, 100), danger(_columns), big_scripts(99), small_scripts(95) {
+    columns = _columns;
+    rows = _rows;
+    time = 0;
+    over = false;
+    for (int i = 0; i < _players; i++) {
+        players.push_back(new Player(columns * (i + 1) / (_players + 1) - 3, rows - 1, 0, columns, 0, rows));
+    }
+    shields = new Shield_wall(shields_count, columns, rows);
+    next_big_enemy = 0;
+    next_small_enemy = 0;
+    next_big_bullets = 0;
+    next_small_bullets = 0;
+    next_big_march = 0;
+    next_small_march = 0;
+}
+
+World::World(const World &other) : danger(other.columns), big_scripts(99), small_scripts(95) {
+    copy(other);
+}
+
+/**
+ * Replaces the whole game with a copy of the other one
+ */
+World &World::operator=(const World &other) {
+    if (this != &other) {
+        release();
+        copy(other);
+    }
+    return *this;
+}
+
+World::~World() {
+    release();
+}
+
+/**
+ * Copies the state and all the actors of the other world. The links between the actors
+ * are translated to the copies: the formations' members and the bullets of the events.
+ * The scripts' frames are copied as they are, every formation keeping the number of its frame.
+ */
+void World::copy(const World &other) {
+    columns = other.columns;
+    rows = other.rows;
+    time = other.time;
+    over = other.over;
+    tally = other.tally;
+    generator = other.generator;
+    distribution = other.distribution;
+    next_big_enemy = other.next_big_enemy;
+    next_small_enemy = other.next_small_enemy;
+    next_big_bullets = other.next_big_bullets;
+    next_small_bullets = other.next_small_bullets;
+    next_big_march = other.next_big_march;
+    next_small_march = other.next_small_march;
+
+    for (Player* player : other.players) {
+        players.push_back(new Player(*player));
+    }
+    shields = new Shield_wall(*other.shields);
+
+    std::unordered_map<const Game_actor*, Game_actor*> enemies;
+    for (Enemy_big_slow* enemy : other.big_enemies) {
+        big_enemies.push_back(new Enemy_big_slow(*enemy));
+        enemies[enemy] = big_enemies.back();
+    }
+    for (Enemy_small_fast* enemy : other.small_enemies) {
+        small_enemies.push_back(new Enemy_small_fast(*enemy));
+        enemies[enemy] = small_enemies.back();
+    }
+    auto copyMember = [&enemies](const Game_actor* member) { return enemies.at(member); };
+    for (Formation* formation : other.big_formations) {
+        big_formations.push_back(formation->copy(copyMember));
+        big_formations.back()->setScript(formation->getScript());
+    }
+    for (Formation* formation : other.small_formations) {
+        small_formations.push_back(formation->copy(copyMember));
+        small_formations.back()->setScript(formation->getScript());
+    }
+    big_scripts = other.big_scripts;
+    small_scripts = other.small_scripts;
+
+    /// Every bullet has exactly one EXIT event, so the queue reaches all of them
+    std::unordered_map<const Bullet*, Bullet*> bullets;
+    events.assign(other.events, [&bullets](const Bullet* bullet) {
+        Bullet* &copied = bullets[bullet];
+        if (copied == nullptr) {
+            copied = bullet->clone();
+        }
+        return copied;
+    });
+    for (Bullet* bullet : other.enemy_bullets) {
+        enemy_bullets.push_back(bullets.at(bullet));
+    }
+    danger.reset(columns);
+    for (SmallBullet* bullet : other.player_bullets) {
+        player_bullets.push_back((SmallBullet*) bullets.at(bullet));
+        danger.add(player_bullets.back());
+    }
+}
+
+/**
+ * Frees all the actors
+ */
+void World::release() {
+    /// Every bullet has exactly one EXIT event, so draining the queue frees all of them
+    events.process(LONG_MAX, [](const Bullet_events::Event &event) {
+        if (event.kind == Bullet_events::EXIT) {
+            delete event.bullet;
+        }
+        return false;
+    });
+    for (Enemy_big_slow* enemy : big_enemies) delete enemy;
+    for (Enemy_small_fast* enemy : small_enemies) delete enemy;
+    for (Formation* formation : big_formations) delete formation;
+    for (Formation* formation : small_formations) delete formation;
+    for (Player* player : players) delete player;
+    delete shields;
+    big_enemies.clear();
+    small_enemies.clear();
+    big_formations.clear();
+    small_formations.clear();
+    enemy_bullets.clear();
+    player_bullets.clear();
+    players.clear();
+}
+
+int World::dice() {
+    return distribution(generator);
+}
+
+/**
+ * Plays one frame of the single player game
+ * @param action what the player does
+ */
+void World::step(Action action) {
+    step(&action);
+}
+
+/**
+ * Plays one frame: applies the players' actions, then runs everything which was due in the frame
+ * @param actions what every player does, the destroyed players' actions are ignored
+ */
+void World::step(const Action* actions) {
+    if (over) return;
+    for (unsigned long i = 0; i < players.size(); i++) {
+        Player* player = players[i];
+        if (player->isDone()) continue;
+        if (actions[i] == ACTION_LEFT) {
+            player->move(-1, 0);
+        } else if (actions[i] == ACTION_RIGHT) {
+            player->move(1, 0);
+        } else if (actions[i] == ACTION_FIRE) {
+            SmallBullet* bullet = new SmallBullet( short(player->getPos_x() + player->getWidth()/2), short(player->getPos_y()),
+                                                   0, columns, 0, player->getPos_y());
+            launch(bullet, time, small_bullets_speed, UP);
+            player_bullets.push_back(bullet);
+            danger.add(bullet);
+        }
+    }
+    time += frame_milis;
+
+    for (; next_big_enemy <= time; next_big_enemy += t_between_big_enemies.count()) {
+        spawnFormation(big_enemies, big_formations, big_formation_columns, RIGHT);
+    }
+    for (; next_small_enemy <= time; next_small_enemy += t_between_small_enemies.count()) {
+        spawnFormation(small_enemies, small_formations, small_formation_columns, LEFT);
+    }
+    /// The scripts tick as often as the formations move a column, like on the scripts' thread of the game
+    for (; next_big_march <= time; next_big_march += 1000/big_slow_enemy_speed) {
+        Enemies_host host(*this, true, 1000/big_slow_enemy_speed, next_big_march);
+        big_scripts.resume(big_formations, host, nullptr);
+    }
+    for (; next_small_march <= time; next_small_march += 1000/small_fast_enemy_speed) {
+        Enemies_host host(*this, false, 1000/small_fast_enemy_speed, next_small_march);
+        small_scripts.resume(small_formations, host, nullptr);
+    }
+    for (; next_big_bullets <= time; next_big_bullets += t_big_enemies_bullets) {
+        for (Enemy_big_slow* enemy : big_enemies) {
+            shoot(*enemy, true, next_big_bullets);
+        }
+    }
+    for (; next_small_bullets <= time; next_small_bullets += t_small_enemies_bullets) {
+        for (Enemy_small_fast* enemy : small_enemies) {
+            shoot(*enemy, false, next_small_bullets);
+        }
+    }
+
+    resolveInterceptions();
+    resolveEvents();
+    resolvePlayerBullets();
+    removeDestroyed();
+    for (Bullet* bullet : exited) {
+        delete bullet;
+    }
+    exited.clear();
+    bool destroyed = true;
+    for (Player* player : players) {
+        destroyed = destroyed && player->isDone();
+    }
+    if (destroyed) {
+        over = true;
+    }
+}
+
+/**
+ * Writes the whole world into the observation. Shields go first, so anything flying
+ * over them stays visible, and the observing player goes last.
+ * @param observation the observation, at least as big as the world
+ * @param player the observing player, the others are seen as allies
+ */
+void World::observe(Observation &observation, int player) const {
+    observation.clear(0, 0);
+    for (Shield* shield : shields->getShields()) {
+        observation.stampShield(shield);
+    }
+    for (Enemy_big_slow* enemy : big_enemies) {
+        observation.stamp(enemy, Observation::BIG_ENEMY);
+    }
+    for (Enemy_small_fast* enemy : small_enemies) {
+        observation.stamp(enemy, Observation::SMALL_ENEMY);
+    }
+    for (Bullet* bullet : enemy_bullets) {
+        if (!bullet->isDone()) {
+            observation.stamp(bullet, Observation::ENEMY_BULLET);
+        }
+    }
+    for (SmallBullet* bullet : player_bullets) {
+        if (!bullet->isDone()) {
+            observation.stamp(bullet, Observation::PLAYER_BULLET);
+        }
+    }
+    for (unsigned long i = 0; i < players.size(); i++) {
+        if (int(i) != player && !players[i]->isDone()) {
+            observation.stamp(players[i], Observation::ALLY);
+        }
+    }
+    observation.stamp(players[player], Observation::PLAYER);
+    observation.setHit_points(players[player]->getHit_points());
+}
+
+/**
+ * Draws the world with the actors' own looks
+ * @param view the viewport
+ */
+void World::draw(const Viewport &view) const {
+    shields->draw(view);
+    for (Formation* formation : big_formations) {
+        if (view.isVisible(formation)) formation->drawActor(view);
+    }
+    for (Formation* formation : small_formations) {
+        if (view.isVisible(formation)) formation->drawActor(view);
+    }
+    for (Bullet* bullet : enemy_bullets) {
+        if (!bullet->isDone() && view.isVisible(bullet)) bullet->drawActor(view);
+    }
+    for (SmallBullet* bullet : player_bullets) {
+        if (!bullet->isDone() && view.isVisible(bullet)) bullet->drawActor(view);
+    }
+    for (Player* player : players) {
+        if (!player->isDone() && view.isVisible(player)) player->drawActor(view);
+    }
+}
+
+/**
+ * @return a hash of the game's state, equal for worlds which played out the same way
+ */
+uint32_t World::checksum() const {
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](long value) {
+        hash = (hash ^ uint32_t(value)) * 16777619u;
+    };
+    mix(time);
+    mix(tally.points);
+    mix(tally.big_ships_destroyed);
+    mix(tally.small_ships_destroyed);
+    for (Player* player : players) {
+        mix(player->getPos_x());
+        mix(player->getHit_points());
+    }
+    for (Enemy_big_slow* enemy : big_enemies) {
+        mix(enemy->getPos_x());
+        mix(enemy->getPos_y());
+    }
+    for (Enemy_small_fast* enemy : small_enemies) {
+        mix(enemy->getPos_x());
+        mix(enemy->getPos_y());
+    }
+    for (Bullet* bullet : enemy_bullets) mix(bullet->getPos_x());
+    for (SmallBullet* bullet : player_bullets) mix(bullet->getPos_x());
+    for (Shield* shield : shields->getShields()) mix(shield->getHit_points());
+    return hash;
+}
+
+void World::launch(Bullet* bullet, long tick, int speed, Direction direction) {
+    bullet->launch(tick, speed, direction);
+    /// All the players are in the bottom row
+    events.track(bullet, shields->getTop(), shields->getBottom(), rows - 1);
+}
+
+/**
+ * Creates a formation of enemies at a random column of the top row
+ */
+template <typename Enemy>
+void World::spawnFormation(std::vector<Enemy*> &enemies, std::vector<Formation*> &formations,
+                           int members, Direction direction) {
+    Formation* formation = Enemy_rules::lineUp<Enemy>(columns/dice(), members, direction, columns, rows);
+    for (Game_actor* member : formation->getMembers()) {
+        enemies.push_back(static_cast<Enemy*>(member));
+    }
+    formations.push_back(formation);
+}
+
+/**
+ * Shoots a bullet from the enemy
+ * @param enemy the enemy
+ * @param big true for a big enemy's bullet, false for a small one's
+ * @param tick the time of the shot in milliseconds
+ */
+void World::shoot(const Game_actor &enemy, bool big, long tick) {
+    Bullet* bullet;
+    int speed;
+    if (big) {
+        bullet = Enemy_rules::bigBullet(enemy, columns, rows);
+        speed = big_bullets_speed;
+    } else {
+        bullet = Enemy_rules::smallBullet(enemy, columns, rows);
+        speed = small_bullets_speed;
+    }
+    launch(bullet, tick, speed, DOWN);
+    enemy_bullets.push_back(bullet);
+}
+
+/**
+ * @param _world the world
+ * @param _big true for the big slow enemies, false for the small fast ones
+ * @param _milis_per_column how long the formations take to move one column
+ * @param _now the time of the tick in milliseconds
+ */
+World::Enemies_host::Enemies_host(World &_world, bool _big, int _milis_per_column, long _now)
+        : world(_world), big(_big), milis_per_column(_milis_per_column), now(_now) {}
+
+int World::Enemies_host::dice() {
+    return world.dice();
+}
+
+Direction World::Enemies_host::evade(const Formation &formation) {
+    return world.danger.evade(formation, now, milis_per_column);
+}
+
+void World::Enemies_host::march(Formation &formation, bool turn) {
+    if (formation.march(turn, *world.shields)) {
+        world.over = true;
+    }
+}
+
+void World::Enemies_host::descend(Formation &formation) {
+    if (formation.descend(*world.shields)) {
+        world.over = true;
+    }
+}
+
+/**
+ * Shoots from at most script_volley members spread over the formation
+ */
+void World::Enemies_host::fire(const Formation &formation) {
+    const std::vector<Game_actor*> &members = formation.getMembers();
+    unsigned long stride = std::max(members.size() / script_volley, 1UL);
+    for (unsigned long i = 0; i < members.size(); i += stride) {
+        if (!members[i]->isDone()) {
+            world.shoot(*members[i], big, now);
+        }
+    }
+}
+
+/**
+ * Shoots down the enemy bullets which met the player's bullets during the frame
+ */
+void World::resolveInterceptions() {
+    interception.clear();
+    for (SmallBullet* bullet : player_bullets) {
+        interception.add(bullet);
+    }
+    for (Bullet* bullet : enemy_bullets) {
+        interception.add(bullet);
+    }
+    interception.sweep(time - frame_milis, time);
+}
+
+void World::resolveEvents() {
+    events.process(time, [this](const Bullet_events::Event &event) {
+        Bullet* bullet = event.bullet;
+        if (event.kind == Bullet_events::SHIELDS) {
+            return shields->erode(bullet, bullet->getBlast());
+        }
+        if (event.kind == Bullet_events::PLAYER) {
+            for (Player* player : players) {
+                if (!player->isDone() && isHit(bullet, player)) {
+                    player->setDamage(bullet->getDamage());
+                    return true;
+                }
+            }
+            return false;
+        }
+        exited.push_back(bullet);
+        return false;
+    });
+}
+
+/**
+ * Moves the player's bullets to the current time and checks them against the enemies,
+ * the big ones first, like the interactive game does
+ */
+void World::resolvePlayerBullets() {
+    for (SmallBullet* bullet : player_bullets) {
+        if (bullet->isDone()) continue;
+        int from_y = bullet->advance(time);
+        bool big = true;
+        Game_actor* enemy = Enemy_rules::firstHit(bullet, from_y, big_formations);
+        if (enemy == nullptr) {
+            big = false;
+            enemy = Enemy_rules::firstHit(bullet, from_y, small_formations);
+        }
+        if (enemy != nullptr) {
+            bullet->setDone();
+            tally.hit(*enemy, 1, big);
+        }
+    }
+}
+
+template <typename T>
+static void remove_done(std::vector<T*> &actors, bool free) {
+    typename std::vector<T*>::iterator it = actors.begin();
+    while (it != actors.end()) {
+        if ((*it)->isDone()) {
+            if ((*it)->getFormation() != nullptr) {
+                (*it)->getFormation()->removeMember(*it);
+            }
+            if (free) {
+                delete *it;
+            }
+            it = actors.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+/**
+ * Removes the done bullets, which are freed at their EXIT events,
+ * and frees the destroyed enemies and the empty formations, their scripts' frames going back to the pools.
+ */
+void World::removeDestroyed() {
+    for (SmallBullet* bullet : player_bullets) {
+        if (bullet->isDone()) {
+            danger.remove(bullet);
+        }
+    }
+    remove_done(enemy_bullets, false);
+    remove_done(player_bullets, false);
+    remove_done(big_enemies, true);
+    remove_done(small_enemies, true);
+    for (Formation* formation : big_formations) {
+        if (formation->isDone()) big_scripts.release(formation);
+    }
+    for (Formation* formation : small_formations) {
+        if (formation->isDone()) small_scripts.release(formation);
+    }
+    remove_done(big_formations, true);
+    remove_done(small_formations, true);
+}
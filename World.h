@@ -0,0 +1,156 @@
+//
+// Created by piotrek on 13.06.17.
+//
+
+#ifndef SPACE_INVADERS_WORLD_H
+#define SPACE_INVADERS_WORLD_H
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include "Action.h"
+#include "Observation.h"
+#include "Player.h"
+#include "Enemy_big_slow.h"
+#include "Enemy_small_fast.h"
+#include "SmallBullet.h"
+#include "BigBullet.h"
+#include "Formation.h"
+#include "Enemy_rules.h"
+#include "Script_scheduler.h"
+#include "Shield_wall.h"
+#include "Bullet_events.h"
+#include "Danger_map.h"
+#include "Interception.h"
+#include "Viewport.h"
+
+/**
+ * Headless game for automated players. It follows the same rules as the interactive game,
+ * the formations being driven by the same scripts, but it has no threads and no clock:
+ * every step advances the game by one frame,
+ * so a game with the same seed and the same actions always plays out the same way.
+ * Several players may share the world, the game is over when all of them are destroyed.
+ * Copying a world copies all of its actors, so a copy is a snapshot which can be
+ * stepped on its own or assigned back to roll the game back.
+ */
+class World {
+public:
+    World(int _columns, int _rows, unsigned int seed, int _players = 1);
+
+    World(const World &other);
+
+    World &operator=(const World &other);
+
+    ~World();
+
+    void step(Action action);
+
+    void step(const Action* actions);
+
+    void observe(Observation &observation, int player = 0) const;
+
+    void draw(const Viewport &view) const;
+
+    uint32_t checksum() const;
+
+    bool isOver() const { return over; }
+
+    long getTime() const { return time; }
+
+    int getPoints() const { return tally.points; }
+
+    int getBig_ships_destroyed() const { return tally.big_ships_destroyed; }
+
+    int getSmall_ships_destroyed() const { return tally.small_ships_destroyed; }
+
+    int getHit_points(int player = 0) const { return players[player]->getHit_points(); }
+
+    int getPlayers() const { return int(players.size()); }
+
+    const Player &getPlayer(int player) const { return *players[player]; }
+
+    int getColumns() const { return columns; }
+
+    int getRows() const { return rows; }
+
+private:
+    /**
+     * The world as seen by the scripts of one kind of enemies during one tick
+     */
+    class Enemies_host : public Script_host {
+    public:
+        Enemies_host(World &_world, bool _big, int _milis_per_column, long _now);
+
+        int dice();
+
+        Direction evade(const Formation &formation);
+
+        void march(Formation &formation, bool turn);
+
+        void descend(Formation &formation);
+
+        void fire(const Formation &formation);
+
+    private:
+        World &world;
+        bool big;
+        int milis_per_column;
+        long now; // the time of the tick
+    };
+
+    int columns;
+    int rows;
+    long time; // milliseconds of the game played
+    bool over;
+    Enemy_rules::Tally tally;
+    std::default_random_engine generator;
+    std::uniform_int_distribution<int> distribution;
+
+    std::vector<Player*> players;
+    Shield_wall* shields;
+    Bullet_events events;
+    Danger_map danger; // the player bullets, for the enemies to evade
+    Interception interception; // scratch space of the bullet sweep, not a part of the state
+    std::vector<Formation*> big_formations;
+    std::vector<Formation*> small_formations;
+    Script_scheduler big_scripts;
+    Script_scheduler small_scripts;
+    std::vector<Enemy_big_slow*> big_enemies;
+    std::vector<Enemy_small_fast*> small_enemies;
+    std::vector<Bullet*> enemy_bullets;
+    std::vector<SmallBullet*> player_bullets;
+    std::vector<Bullet*> exited; // bullets to be freed at the end of the step
+
+    /// When the periodic parts of the game are due next, in milliseconds
+    long next_big_enemy;
+    long next_small_enemy;
+    long next_big_bullets;
+    long next_small_bullets;
+    long next_big_march; // the next tick of the big enemies' scripts
+    long next_small_march; // the next tick of the small enemies' scripts
+
+    int dice();
+
+    void copy(const World &other);
+
+    void release();
+
+    void launch(Bullet* bullet, long tick, int speed, Direction direction);
+
+    template <typename Enemy>
+    void spawnFormation(std::vector<Enemy*> &enemies, std::vector<Formation*> &formations,
+                        int members, Direction direction);
+
+    void shoot(const Game_actor &enemy, bool big, long tick);
+
+    void resolveInterceptions();
+
+    void resolveEvents();
+
+    void resolvePlayerBullets();
+
+    void removeDestroyed();
+};
+
+
+#endif //SPACE_INVADERS_WORLD_H
@@ -1,4 +1,6 @@
 #include <iostream>
+#include <string>
+#include <cstdlib>
 #include <chrono>
 #include <thread>
 #include <ncurses.h>
@@ -6,6 +8,11 @@
 #include <vector>
 #include <atomic>
 #include <random>
+#include <functional>
+#include <algorithm>
+#include <unistd.h>
+#include <clocale>
+#include <cstdarg>
 #include "SmallBullet.h"
 #include "Direction.h"
 #include "Player.h"
@@ -13,25 +20,66 @@
 #include "BigBullet.h"
 #include "Enemy_small_fast.h"
 #include "Shield.h"
+#include "Shield_wall.h"
+#include "Game_rules.h"
+#include "Enemy_rules.h"
+#include "Observation.h"
+#include "Keyboard_policy.h"
+#include "Aim_policy.h"
+#include "Vector_env.h"
+#include "Game_mutex.h"
+#include "Viewport.h"
+#include "Spatial_index.h"
+#include "Formation.h"
+#include "Bullet_events.h"
+#include "Danger_map.h"
+#include "Interception.h"
+#include "Narrowphase.h"
+#include "Command_buffer.h"
+#include "Script_scheduler.h"
+#include "Cast_recorder.h"
+#include "Trace.h"
+#include "Memory_stats.h"
+#include "Frame_governor.h"
+#include "Output_pacer.h"
+#include "Braille_layer.h"
+#include "Particles.h"
+#include "Epoch.h"
+#include "Published.h"
+#include "Score_log.h"
+#include "Coop_server.h"
+#include "Coop_client.h"
+#include "Delay_proxy.h"
 
-static const std::chrono::milliseconds frame_durtion(40); // 40 FPS
-static const std::chrono::milliseconds t_between_big_enemies(12000); // new big enemy every 8 seconds
-static const std::chrono::milliseconds t_between_small_enemies(4000); // new small enemy every 4 seconds
-static const int t_big_enemies_bullets= 4000;
-static const int t_small_enemies_bullets= 500;
-static const int small_bullets_speed = 30; // rows per second
-static const int big_bullets_speed = 15; //rows per sec_ond
-static const int big_slow_enemy_speed = 10; // columns per second
-static const int small_fast_enemy_speed = 20; // columns per second
-static const int SPACE = 32;
 static std::atomic_bool exit_condition(false);
 static std::atomic_bool game_over(false);
 static std::default_random_engine generator;
 static std::uniform_int_distribution<int> distribution(1,100);
 static auto dice = std::bind ( distribution, generator );
-static int POINTS = 0;
-static int BIG_SHIPS_DESTROYED = 0;
-static int SMALL_SHIPS_DESTROYED = 0;
+static Enemy_rules::Tally tally; // the score, counted at the frame's end as the hits are applied
+static const std::chrono::steady_clock::time_point game_start = std::chrono::steady_clock::now();
+
+/// World, larger than the terminal, and the camera showing a part of it
+static const int world_columns_factor = 4; // world width in terminal widths
+static const int world_rows_factor = 2; // world height in terminal heights
+static int world_maxx = 0;
+static int world_maxy = 0;
+static Viewport* viewport;
+
+/// Swarm mode: the small enemies come in crowds until there are swarm_size of them, 0 for the normal game
+static unsigned long swarm_size = 0;
+static const unsigned long swarm_waves = 8; // the swarm arrives in that many waves
+static const int swarm_rows = 8; // the height of a wave
+static const unsigned long swarm_volley = 32; // the swarm's enemies shooting at once
+
+/// Spatial indexes used to draw only the actors inside the viewport
+static Spatial_index* enemies_index;
+static Spatial_index* enemy_bullets_index;
+static Spatial_index* player_bullets_index;
+
+/// Predicted bullet events and the row of the player they are predicted against
+static Bullet_events bullet_events;
+static int player_row = 0;
 
 /// Bullets' vector
 static std::vector<BigBullet*> big_bullets_vector;
@@ -42,43 +90,108 @@ static std::vector<SmallBullet*> player_bullets_vector;
 static std::vector<Enemy_big_slow*> big_slow_enemies_vector;
 static std::vector<Enemy_small_fast*> small_fast_enemies_vector;
 
-/// Shield
-static Shield* shield;
+/// Copies of the enemies' vectors for the shooting threads, which read them without locks
+static Published<std::vector<Enemy_big_slow*>> big_slow_enemies_published;
+static Published<std::vector<Enemy_small_fast*>> small_fast_enemies_published;
+
+/// Bullets past their last event, retired once they are out of the vectors. Used by the rendering thread only
+static std::vector<Bullet*> exited_bullets;
+
+/// Formations' vectors, guarded by the enemies' mutexes
+static std::vector<Formation*> big_formations_vector;
+static std::vector<Formation*> small_formations_vector;
+
+/// The formations' scripts, guarded by the enemies' mutexes, run by the scripts' thread
+static Script_scheduler big_scripts(99);
+static Script_scheduler small_scripts(95);
+
+/// Shields
+static Shield_wall* shields;
+
+/// The player's bullets by column, guarded by danger_mutex, which is never held while taking another lock
+static Danger_map* danger_map;
+
+/// The collections changed by the deferred commands
+enum Command_target { PLAYER_BULLETS, SMALL_BULLETS, BIG_BULLETS, BIG_FORMATIONS, SMALL_FORMATIONS,
+                      BIG_ENEMIES, SMALL_ENEMIES };
+
+/// Checks the player's bullets against the enemies on all the cores, used by the rendering thread
+static Narrowphase* narrowphase;
+
+/// Shooting the enemy bullets down, touched only by the rendering thread
+static Interception interception;
+static long last_interception_tick = -1;
+
+/// The session's recording, fed by the rendering thread, nullptr when not recording
+static Cast_recorder* recorder = nullptr;
+
+/// Every finished game is appended to the score log
+static const char* score_log_path = "space_invaders.scores";
+static Score_log* score_log;
+
+/// Explosion debris, touched only by the rendering thread
+static Particles particles(100000);
+
+/// The dots of the bullets and the debris in the Braille mode, touched only by the rendering thread
+static Braille_layer braille;
+
+/// Sheds the cosmetic work when the frames run over their budget, touched only by the rendering thread
+static Frame_governor governor(frame_durtion);
+
+/// Writes the frames to the terminal at the pace of the link, fed by the rendering thread
+static Output_pacer* output;
 
 /// Mutexes
-static std::mutex player_bullets_mutex;
-static std::mutex small_bullets_mutex;
-static std::mutex big_bullets_mutex;
-static std::mutex big_enemies_mutex;
-static std::mutex small_enemies_mutex;
-static std::mutex player_mutex;
-static std::mutex ncurses_mutex;
+static Game_mutex player_bullets_mutex("player_bullets");
+static Game_mutex small_bullets_mutex("small_bullets");
+static Game_mutex big_bullets_mutex("big_bullets");
+static Game_mutex big_enemies_mutex("big_enemies");
+static Game_mutex small_enemies_mutex("small_enemies");
+static Game_mutex player_mutex("player");
+static Game_mutex ncurses_mutex("ncurses");
+static Game_mutex danger_mutex("danger");
 
 /// Colors' modes
 static const short MODE_GREEN = 1;
 static const short MODE_RED = 2;
 
-bool isHit(Game_actor* bullet, Game_actor* actor);
+long current_tick();
+void track_bullet(Bullet* bullet, Spatial_index* index);
+void apply_commands();
+void trace_counts();
+void sample_vectors();
+void process_bullet_events(Player &player);
+void intercept_bullets(long now);
+void draw_indexed(Spatial_index* index, short color_mode);
 void handle_bullet_hits(Player &player);
 void remove_destroyed_enemies();
+void explode(Game_actor* actor, int amount);
 void remove_used_bullets();
-void draw_bullets();
-void shoot_small_bullets();
+void draw_bullets(bool dots);
+void draw_bullets_indexed(Spatial_index* index, short color_mode, long now, bool dots);
 void player_shoots(Game_actor &player);
-void draw_enemies();
+void draw_enemies(bool coarse);
 void draw_health(Player &player);
+int print_hud(WINDOW* hud, int line, const char* format, ...);
+void observe_game(Observation &observation, Player &player);
+void apply_action(Player &player, Action action);
+int run_headless(int games, int frames);
+int run_server(const char* path, int players, unsigned int seed);
+int run_client(const char* path, bool bot);
+void run_enemy_scripts();
+void remove_empty_formations(std::vector<Formation*> &formations, Script_scheduler &scripts);
 /// Big enemies functions
-void move_big_slow_enemies();
 void create_big_slow_enemies_bullets();
-void shoot_big_bullets();
 void big_slow_enemy_shoots(Enemy_big_slow &enemy);
 void create_big_enemy();
 
 /// Small enemies functions
-void move_small_fast_enemies();
 void create_small_fast_enemies_bullets();
 void small_fast_enemy_shoots(Enemy_small_fast &enemy);
 void create_small_enemy();
+void create_swarm_wave();
+bool hit_formations(unsigned long bullet, int from_y, std::vector<Formation*> &formations, Command_target target,
+                    std::vector<Narrowphase::Hit> &hits);
 
 
 /// Main view rendering function and game loop
@@ -88,9 +201,10 @@ void create_small_enemy();
  * @param player a reference to player object
  */
 void refresh_view(Player &player) {
+    Trace::nameThread("render");
 
-    int row = getmaxy( stdscr )/2 - 2;
-    int col = getmaxx( stdscr) / 2 - 8;
+    int row = 0;
+    int col = 0;
 
     /// Launch big enemies creation thread
     std::thread big_enemies_creation_thread(create_big_enemy);
@@ -98,68 +212,142 @@ void refresh_view(Player &player) {
     /// Launch small enemies creation thread
     std::thread small_enemies_creation_thread(create_small_enemy);
 
-    /// Launch big enemies movement thread
-    std::thread move_big_slow_enemies_thread( move_big_slow_enemies );
-
-    /// Launch small enemies movement thread
-    std::thread move_small_fast_enemies_thread( move_small_fast_enemies );
+    /// Launch enemies' scripts thread
+    std::thread enemy_scripts_thread( run_enemy_scripts );
 
     /// Launch small fast enemies shooting thread
     std::thread small_fast_enemies_shooting_thread( create_small_fast_enemies_bullets );
 
-    /// Launch small bullets shooting thread
-    std::thread small_bullets_thread(shoot_small_bullets);
-
     /// Launch big slow enemies shooting thread
     std::thread big_slow_enemies_shooting_thread( create_big_slow_enemies_bullets );
 
-    /// Launch big bullets shooting thread
-    std::thread big_bullets_thread( shoot_big_bullets );
-
+    long last_frame = current_tick();
+    /// The HUD's lines are printed into a pad of their own and copied onto every frame,
+    /// a slowed HUD is formatted and printed only when it is refreshed
+    const int hud_lines = 4;
+    WINDOW* hud = newpad(hud_lines, 1);
+    int hud_widths[hud_lines] = {};
     while (!exit_condition) {
+        std::chrono::steady_clock::time_point frame_begin = std::chrono::steady_clock::now();
+        int64_t frame_start = Trace::clock();
+        long now = current_tick();
+        /// A frame coming more than a quarter of its budget late is marked across all the threads,
+        /// the locks held meanwhile show who held it up
+        if (now - last_frame > frame_durtion.count() * 5 / 4) {
+            Trace::instant("frame overrun");
+        }
+        particles.update((now - last_frame) / 1000.0f);
+        last_frame = now;
         clear();
+        /// A resized terminal only changes the size of the viewport and the centre of the screen,
+        /// the world and the actors don't depend on it
+        int screen_columns = getmaxx( stdscr );
+        int screen_rows = getmaxy( stdscr );
+        row = screen_rows/2 - 2;
+        col = screen_columns/2 - 8;
+        /// In the Braille mode the bullets and the debris are composited into dots and printed last
+        bool dots = Braille_layer::isEnabled();
+        if (dots) {
+            braille.clear(screen_columns, screen_rows);
+        }
         attron( A_BOLD );
-        shield->drawActor();
+        player_mutex.lock();
+        if (screen_columns != viewport->getColumns() || screen_rows != viewport->getRows()) {
+            viewport->resize(screen_columns, screen_rows);
+        }
+        viewport->follow(player);
+        player_mutex.unlock();
+        shields->draw(*viewport);
         player_mutex.lock();
         ncurses_mutex.lock();
-        player.drawActor();
+        player.drawActor(*viewport);
         ncurses_mutex.unlock();
         player_mutex.unlock();
-        draw_enemies();
+        draw_enemies(governor.sheds(Frame_governor::COARSE_DISTANT));
         attroff( A_BOLD );
 
         remove_used_bullets();
         handle_bullet_hits(player);
+        apply_commands();
         if (player.isDone()) {
             game_over = true;
         }
         remove_destroyed_enemies();
+        trace_counts();
+        if (dots && !governor.sheds(Frame_governor::NO_EFFECTS)) {
+            particles.drawDots(*viewport, braille, MODE_RED);
+        } else if (!governor.sheds(Frame_governor::NO_EFFECTS)) {
+            ncurses_mutex.lock();
+            attron( COLOR_PAIR(MODE_RED));
+            particles.draw(*viewport);
+            attroff( COLOR_PAIR(MODE_RED));
+            ncurses_mutex.unlock();
+        }
 
+        /// The health is always current, the other figures are printed less often when the HUD is slowed
         draw_health(player);
-        mvprintw(1,0, "Bombers destroyed: %d", BIG_SHIPS_DESTROYED);
-        mvprintw(2,0, "Small fighters destroyed: %d", SMALL_SHIPS_DESTROYED);
-        mvprintw(3,0, "TOTAL SCORE: %d", POINTS);
-        draw_bullets();
+        if (governor.refreshesHud()) {
+            if (getmaxx(hud) != screen_columns) {
+                wresize(hud, hud_lines, screen_columns);
+            }
+            werase(hud);
+            hud_widths[0] = print_hud(hud, 0, "Bombers destroyed: %d", tally.big_ships_destroyed);
+            hud_widths[1] = print_hud(hud, 1, "Small fighters destroyed: %d", tally.small_ships_destroyed);
+            hud_widths[2] = print_hud(hud, 2, "TOTAL SCORE: %d", tally.points);
+            hud_widths[3] = 0;
+            if (Memory_stats::isHudShown()) {
+                sample_vectors();
+                hud_widths[3] = print_hud(hud, 3, "%s", Memory_stats::summary().c_str());
+            }
+        }
+        for (int line = 0; line < hud_lines && line + 1 < screen_rows; line++) {
+            int width = std::min(hud_widths[line], screen_columns);
+            if (width > 0) {
+                copywin(hud, stdscr, line, 0, line + 1, 0, line + 1, width - 1, FALSE);
+            }
+        }
+        draw_bullets(dots);
+        if (dots) {
+            Trace::Scope scope("draw dots");
+            ncurses_mutex.lock();
+            braille.draw();
+            ncurses_mutex.unlock();
+        }
 
-        refresh();
+        {
+            Trace::Scope scope("present");
+            output->present(stdscr);
+        }
+        if (recorder != nullptr) {
+            recorder->capture(stdscr);
+        }
+        Trace::slice("frame", "frame", frame_start);
+        governor.measure(now, std::chrono::steady_clock::now() - frame_begin);
 
         if (game_over) {
+            output->stop();
             clear();
             exit_condition = true;
             attron( A_BOLD );
             attron( COLOR_PAIR(MODE_RED));
             mvprintw( row, col, "GAME OVER!");
-            mvprintw(row + 1, col, "Bombers destroyed: %d", BIG_SHIPS_DESTROYED);
-            mvprintw(row + 2, col, "Small fighters destroyed: %d", SMALL_SHIPS_DESTROYED);
-            mvprintw(row + 3, col, "TOTAL SCORE: %d", POINTS);
+            mvprintw(row + 1, col, "Bombers destroyed: %d", tally.big_ships_destroyed);
+            mvprintw(row + 2, col, "Small fighters destroyed: %d", tally.small_ships_destroyed);
+            mvprintw(row + 3, col, "TOTAL SCORE: %d", tally.points);
+            score_log->append(tally.points, tally.big_ships_destroyed, tally.small_ships_destroyed);
             attroff( COLOR_PAIR(MODE_RED));
             attroff( A_BOLD );
             refresh();
+            if (recorder != nullptr) {
+                recorder->capture(stdscr);
+            }
             break;
         } else {
-            std::this_thread::sleep_for(frame_durtion);
+            std::this_thread::sleep_until(frame_begin + frame_durtion);
         }
     }
+    output->stop();
+    delwin(hud);
     refresh();
     game_over = true;
     mvprintw(row + 4, col, "Finishing threads...");
@@ -168,148 +356,413 @@ void refresh_view(Player &player) {
     mvprintw(row + 5, col, "- big enemies creation thread: FINISHED");
     small_enemies_creation_thread.join();
     mvprintw(row + 6, col, "- small enemies creation thread: FINISHED");
-    move_big_slow_enemies_thread.join();
-    mvprintw(row + 7, col, "- big enemies motion thread: FINISHED");
-    move_small_fast_enemies_thread.join();
-    mvprintw(row + 8, col, "- small enemies motion thread: FINISHED");
+    enemy_scripts_thread.join();
+    mvprintw(row + 7, col, "- enemies' scripts thread: FINISHED");
     big_slow_enemies_shooting_thread.join();
-    mvprintw(row + 9, col, "- big enemies shooting thread: FINISHED");
+    mvprintw(row + 8, col, "- big enemies shooting thread: FINISHED");
     small_fast_enemies_shooting_thread.join();
-    mvprintw(row + 10, col, "- small enemies shooting thread: FINISHED");
-    big_bullets_thread.join();
-    mvprintw(row + 11, col, "- big bullets motion thread: FINISHED");
-    small_bullets_thread.join();
-    mvprintw(row + 12, col, "- small bullets motion thread: FINISHED");
-    mvprintw(row + 13, col, "Finished all tasks!");
-    mvprintw(row + 14, col, "Press 'q' to quit...");
+    mvprintw(row + 9, col, "- small enemies shooting thread: FINISHED");
+    mvprintw(row + 10, col, "Finished all tasks!");
+    mvprintw(row + 11, col, "Press 'q' to quit...");
     refresh();
 }
 //////////////////////////////////////////////
 
-bool isHit(Game_actor* bullet, Game_actor* actor) {
-    int bullet_x = bullet->getPos_x();
-    int bullet_y = bullet->getPos_y();
-    int bullet_w = bullet->getWidth();
-    int bullet_h = bullet->getHeight();
-    int actor_x_min = actor->getPos_x();
-    int actor_x_max = actor_x_min + actor->getWidth();
-    int actor_y_min = actor->getPos_y();
-    int actor_y_max = actor_y_min + actor->getHeight();
+/**
+ * @return milliseconds since the start of the game
+ */
+long current_tick() {
+    return (long) std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - game_start).count();
+}
 
-    actor_x_min -= bullet_w;
-    actor_y_min -= bullet_h;
+/**
+ * Predicts when the launched bullet reaches the shields, the player's row and the end of its course.
+ * @param bullet the bullet
+ * @param index the index the bullet is drawn from
+ */
+void track_bullet(Bullet* bullet, Spatial_index* index) {
+    bullet_events.track(bullet, shields->getTop(), shields->getBottom(), player_row);
+    index->insert(bullet);
+}
 
-    return bullet_x > actor_x_min
-           && bullet_x < actor_x_max
-            && bullet_y > actor_y_min
-            && bullet_y < actor_y_max;
+/**
+ * Adds a run of spawned actors to their vector, growing it once
+ * @param actors the vector
+ * @param first the first spawn command
+ * @param last past the last spawn command
+ */
+template <typename T>
+static void spawn_all(std::vector<T*> &actors, const Command_buffer::Command* first, const Command_buffer::Command* last) {
+    actors.reserve(actors.size() + (last - first));
+    for (const Command_buffer::Command* command = first; command != last; command++) {
+        actors.push_back(static_cast<T*>(command->actor));
+    }
 }
 
-void handle_bullet_hits(Player &player) {
-    small_bullets_mutex.lock();
-    for (SmallBullet* bullet : small_bullets_vector) {
-        if (!shield->isDone() && isHit(bullet, shield)) {
-            bullet->setDone();
-            shield->setDamage(1);
-            continue;
+/**
+ * Applies a run of commands to the bullets of a vector under its mutex
+ */
+template <typename T>
+static void apply_bullets(std::vector<T*> &bullets, Game_mutex &mutex, Spatial_index* index,
+                          const Command_buffer::Command* first, const Command_buffer::Command* last) {
+    mutex.lock();
+    if (first->kind == Command_buffer::SPAWN) {
+        for (const Command_buffer::Command* command = first; command != last; command++) {
+            track_bullet(static_cast<Bullet*>(command->actor), index);
         }
-        if (isHit(bullet, &player)) {
-            bullet->setDone();
-            player.setDamage(1);
+        spawn_all(bullets, first, last);
+    } else {
+        for (const Command_buffer::Command* command = first; command != last; command++) {
+            command->actor->setDone();
         }
     }
-    small_bullets_mutex.unlock();
+    mutex.unlock();
+}
 
-    big_bullets_mutex.lock();
-    for (BigBullet* bullet : big_bullets_vector) {
-        if (!shield->isDone() && isHit(bullet, shield)) {
-            bullet->setDone();
-            shield->setDamage(5);
-            continue;
-        }
-        if (isHit(bullet, &player)) {
-            bullet->setDone();
-            player.setDamage(5);
+/**
+ * Applies a run of commands to the enemies of a vector under its mutex.
+ * The hits are scored by the rules shared with the headless world.
+ */
+template <typename T>
+static void apply_enemies(std::vector<T*> &enemies, Published<std::vector<T*>> &published, Game_mutex &mutex,
+                          bool big, const Command_buffer::Command* first, const Command_buffer::Command* last) {
+    mutex.lock();
+    if (first->kind == Command_buffer::SPAWN) {
+        spawn_all(enemies, first, last);
+        published.publish(enemies);
+    } else {
+        for (const Command_buffer::Command* command = first; command != last; command++) {
+            if (command->kind == Command_buffer::DAMAGE) {
+                tally.hit(*command->actor, command->amount, big);
+            } else {
+                tally.destroy(*command->actor, big);
+            }
         }
     }
+    mutex.unlock();
+}
+
+/**
+ * The frame's boundary: applies the spawns, hits and removals recorded since the previous one
+ */
+void apply_commands() {
+    Trace::Scope scope("apply commands");
+    Command_buffer::apply([](const Command_buffer::Command* first, const Command_buffer::Command* last) {
+        switch (first->target) {
+            case PLAYER_BULLETS:
+                apply_bullets(player_bullets_vector, player_bullets_mutex, player_bullets_index, first, last);
+                if (first->kind == Command_buffer::SPAWN) {
+                    danger_mutex.lock();
+                    for (const Command_buffer::Command* command = first; command != last; command++) {
+                        danger_map->add(static_cast<Bullet*>(command->actor));
+                    }
+                    danger_mutex.unlock();
+                }
+                break;
+            case SMALL_BULLETS:
+                apply_bullets(small_bullets_vector, small_bullets_mutex, enemy_bullets_index, first, last);
+                break;
+            case BIG_BULLETS:
+                apply_bullets(big_bullets_vector, big_bullets_mutex, enemy_bullets_index, first, last);
+                break;
+            case BIG_FORMATIONS:
+                big_enemies_mutex.lock();
+                for (const Command_buffer::Command* command = first; command != last; command++) {
+                    enemies_index->insert(command->actor);
+                }
+                spawn_all(big_formations_vector, first, last);
+                big_enemies_mutex.unlock();
+                break;
+            case SMALL_FORMATIONS:
+                small_enemies_mutex.lock();
+                for (const Command_buffer::Command* command = first; command != last; command++) {
+                    enemies_index->insert(command->actor);
+                }
+                spawn_all(small_formations_vector, first, last);
+                small_enemies_mutex.unlock();
+                break;
+            case BIG_ENEMIES:
+                apply_enemies(big_slow_enemies_vector, big_slow_enemies_published, big_enemies_mutex,
+                              true, first, last);
+                break;
+            case SMALL_ENEMIES:
+                apply_enemies(small_fast_enemies_vector, small_fast_enemies_published, small_enemies_mutex,
+                              false, first, last);
+                break;
+            default:
+                break;
+        }
+    });
+}
+
+/**
+ * Records the numbers of the bullets and the enemies, while tracing
+ */
+void trace_counts() {
+    if (!Trace::isEnabled()) return;
+    player_bullets_mutex.lock();
+    long player_bullets = (long) player_bullets_vector.size();
+    player_bullets_mutex.unlock();
+    small_bullets_mutex.lock();
+    long enemy_bullets = (long) small_bullets_vector.size();
+    small_bullets_mutex.unlock();
+    big_bullets_mutex.lock();
+    enemy_bullets += (long) big_bullets_vector.size();
     big_bullets_mutex.unlock();
+    Epoch::Guard guard;
+    Trace::counter("player bullets", player_bullets);
+    Trace::counter("enemy bullets", enemy_bullets);
+    Trace::counter("big enemies", (long) big_slow_enemies_published.read().size());
+    Trace::counter("small enemies", (long) small_fast_enemies_published.read().size());
+}
 
+/**
+ * Records the sizes and capacities of the shared vectors for the memory accounting
+ */
+void sample_vectors() {
     player_bullets_mutex.lock();
-    for (SmallBullet* bullet : player_bullets_vector) {
-        if (!shield->isDone() && isHit(bullet, shield)) {
-            bullet->setDone();
-            shield->setDamage(1);
-            continue;
+    Memory_stats::sampleVector("player_bullets_vector", player_bullets_vector.size(), player_bullets_vector.capacity(),
+                               sizeof(SmallBullet*));
+    player_bullets_mutex.unlock();
+    small_bullets_mutex.lock();
+    Memory_stats::sampleVector("small_bullets_vector", small_bullets_vector.size(), small_bullets_vector.capacity(),
+                               sizeof(SmallBullet*));
+    small_bullets_mutex.unlock();
+    big_bullets_mutex.lock();
+    Memory_stats::sampleVector("big_bullets_vector", big_bullets_vector.size(), big_bullets_vector.capacity(),
+                               sizeof(BigBullet*));
+    big_bullets_mutex.unlock();
+    big_enemies_mutex.lock();
+    Memory_stats::sampleVector("big_slow_enemies_vector", big_slow_enemies_vector.size(),
+                               big_slow_enemies_vector.capacity(), sizeof(Enemy_big_slow*));
+    Memory_stats::sampleVector("big_formations_vector", big_formations_vector.size(), big_formations_vector.capacity(),
+                               sizeof(Formation*));
+    big_enemies_mutex.unlock();
+    small_enemies_mutex.lock();
+    Memory_stats::sampleVector("small_fast_enemies_vector", small_fast_enemies_vector.size(),
+                               small_fast_enemies_vector.capacity(), sizeof(Enemy_small_fast*));
+    Memory_stats::sampleVector("small_formations_vector", small_formations_vector.size(),
+                               small_formations_vector.capacity(), sizeof(Formation*));
+    small_enemies_mutex.unlock();
+    Memory_stats::sampleVector("exited_bullets", exited_bullets.size(), exited_bullets.capacity(), sizeof(Bullet*));
+}
+
+/**
+ * Handles all the bullet events which are due
+ * @param player the player
+ */
+void process_bullet_events(Player &player) {
+    bullet_events.process(current_tick(), [&player](const Bullet_events::Event &event) {
+        Bullet* bullet = event.bullet;
+        if (event.kind == Bullet_events::SHIELDS) {
+            return shields->erode(bullet, bullet->getBlast());
         }
-        big_enemies_mutex.lock();
-        for (Enemy_big_slow* enemy : big_slow_enemies_vector) {
-            if (isHit(bullet, enemy)) {
-                bullet->setDone();
-                enemy->setDamage(1);
-                if (enemy->isDone()){
-                    BIG_SHIPS_DESTROYED++;
-                }
-                POINTS++;
+        if (event.kind == Bullet_events::PLAYER) {
+            player_mutex.lock();
+            bool hit = isHit(bullet, &player);
+            if (hit) {
+                player.setDamage(bullet->getDamage());
             }
+            player_mutex.unlock();
+            return hit;
         }
-        big_enemies_mutex.unlock();
-        small_enemies_mutex.lock();
-        for (Enemy_small_fast* enemy : small_fast_enemies_vector) {
-            if (isHit(bullet, enemy)) {
-                bullet->setDone();
-                enemy->setDamage(1);
-                SMALL_SHIPS_DESTROYED++;
-                POINTS++;
+        exited_bullets.push_back(bullet);
+        return false;
+    });
+}
+
+/**
+ * Shoots down the enemy bullets which met the player's bullets since the last frame
+ * @param now the current time in milliseconds
+ */
+void intercept_bullets(long now) {
+    if (last_interception_tick < 0) {
+        last_interception_tick = now;
+    }
+    interception.clear();
+    player_bullets_mutex.lock();
+    for (SmallBullet* bullet : player_bullets_vector) {
+        interception.add(bullet);
+    }
+    small_bullets_mutex.lock();
+    for (SmallBullet* bullet : small_bullets_vector) {
+        interception.add(bullet);
+    }
+    small_bullets_mutex.unlock();
+    big_bullets_mutex.lock();
+    for (BigBullet* bullet : big_bullets_vector) {
+        interception.add(bullet);
+    }
+    big_bullets_mutex.unlock();
+    interception.sweep(last_interception_tick, now);
+    player_bullets_mutex.unlock();
+    last_interception_tick = now;
+}
+
+/**
+ * Shoots down the intercepted bullets and resolves the due bullet events, then moves the player's
+ * bullets to the current time and checks them against the enemies they could have passed since
+ * the last frame. The bullets are checked in parallel, each thread only moving its own bullets
+ * and reading the enemies, and the hits are recorded in the bullets' order, to be applied
+ * at the end of the frame.
+ * @param player the player
+ */
+void handle_bullet_hits(Player &player) {
+    Trace::Scope scope("bullet hits");
+    long now = current_tick();
+    intercept_bullets(now);
+    process_bullet_events(player);
+
+    player_bullets_mutex.lock();
+    big_enemies_mutex.lock();
+    small_enemies_mutex.lock();
+    const std::vector<Narrowphase::Hit> &hits = narrowphase->detect(player_bullets_vector.size(),
+            [now](unsigned long first, unsigned long last, std::vector<Narrowphase::Hit> &found) {
+        for (unsigned long i = first; i < last; i++) {
+            SmallBullet* bullet = player_bullets_vector[i];
+            if (bullet->isDone()) continue;
+            int from_y = bullet->advance(now);
+            if (!hit_formations(i, from_y, big_formations_vector, BIG_ENEMIES, found)) {
+                hit_formations(i, from_y, small_formations_vector, SMALL_ENEMIES, found);
             }
         }
-        small_enemies_mutex.unlock();
+    });
+    small_enemies_mutex.unlock();
+    big_enemies_mutex.unlock();
+    for (const Narrowphase::Hit &hit : hits) {
+        Command_buffer::destroy(PLAYER_BULLETS, player_bullets_vector[hit.bullet]);
+        Command_buffer::damage(hit.target, hit.enemy, hit.damage);
     }
     player_bullets_mutex.unlock();
+    Command_buffer::submit(now);
+}
+
+/**
+ * Finds the first enemy the bullet has passed since the last frame. Only the members
+ * of the formations whose box the bullet has passed are checked, so a crowd costs nothing
+ * to the bullets flying by. Reads the enemies only, so the bullets can be checked concurrently.
+ * Must be called with the enemies' mutex locked.
+ * @param bullet the place of the player's bullet in its vector
+ * @param from_y the bullet's row in the previous frame
+ * @param formations the formations of the enemies
+ * @param target the enemies' vector, to be damaged at the end of the frame
+ * @param hits the buffer to record the hit into
+ * @return true if the bullet has hit an enemy
+ */
+bool hit_formations(unsigned long bullet, int from_y, std::vector<Formation*> &formations, Command_target target,
+                    std::vector<Narrowphase::Hit> &hits) {
+    Game_actor* enemy = Enemy_rules::firstHit(player_bullets_vector[bullet], from_y, formations);
+    if (enemy == nullptr) return false;
+    hits.push_back({bullet, target, enemy, 1});
+    return true;
 }
 void remove_destroyed_enemies() {
+    Trace::Scope scope("remove enemies");
+    /// Enemies die only of the damage applied at the frame's end, which counts them,
+    /// so the vectors are searched only when the counts have changed
+    static int big_ships_removed = 0;
+    static int small_ships_removed = 0;
+    bool removed = false;
     big_enemies_mutex.lock();
-    if (big_slow_enemies_vector.size() > 0) {
+    if (big_slow_enemies_vector.size() > 0 && big_ships_removed != tally.big_ships_destroyed) {
+        big_ships_removed = tally.big_ships_destroyed;
         std::vector<Enemy_big_slow*>::iterator it = big_slow_enemies_vector.begin();
         int j = 0;
         while (it != big_slow_enemies_vector.end()) {
             if (big_slow_enemies_vector[j]->isDone()) {
+                explode(big_slow_enemies_vector[j], 60);
+                if (big_slow_enemies_vector[j]->getFormation() != nullptr) {
+                    big_slow_enemies_vector[j]->getFormation()->removeMember(big_slow_enemies_vector[j]);
+                }
+                Epoch::retire(big_slow_enemies_vector[j]);
                 it = big_slow_enemies_vector.erase(it);
+                removed = true;
             } else {
                 j++; it++;
             }
         }
     }
+    if (removed) {
+        big_slow_enemies_published.publish(big_slow_enemies_vector);
+    }
+    remove_empty_formations(big_formations_vector, big_scripts);
     big_enemies_mutex.unlock();
 
+    removed = false;
     small_enemies_mutex.lock();
-    if (small_fast_enemies_vector.size() > 0) {
+    if (small_fast_enemies_vector.size() > 0 && small_ships_removed != tally.small_ships_destroyed) {
+        small_ships_removed = tally.small_ships_destroyed;
         std::vector<Enemy_small_fast*>::iterator it = small_fast_enemies_vector.begin();
         int j = 0;
         while (it != small_fast_enemies_vector.end()) {
             if (small_fast_enemies_vector[j]->isDone()) {
+                explode(small_fast_enemies_vector[j], 25);
+                if (small_fast_enemies_vector[j]->getFormation() != nullptr) {
+                    small_fast_enemies_vector[j]->getFormation()->removeMember(small_fast_enemies_vector[j]);
+                }
+                Epoch::retire(small_fast_enemies_vector[j]);
                 it = small_fast_enemies_vector.erase(it);
+                removed = true;
             } else {
                 j++; it++;
             }
         }
     }
+    if (removed) {
+        small_fast_enemies_published.publish(small_fast_enemies_vector);
+    }
+    remove_empty_formations(small_formations_vector, small_scripts);
     small_enemies_mutex.unlock();
 }
+/**
+ * Blows the actor up into debris, centred on its absolute position, unless the effects are shed.
+ * Must be called before the actor leaves its formation.
+ * @param actor the destroyed actor
+ * @param amount the number of particles
+ */
+void explode(Game_actor* actor, int amount) {
+    if (governor.sheds(Frame_governor::NO_EFFECTS)) return;
+    particles.emit(actor->getPos_x() + actor->getWidth() / 2.0f, actor->getPos_y() + actor->getHeight() / 2.0f,
+                   amount, 12.0f, 1.2f);
+}
+
+/**
+ * Removes the formations which have lost all their members and retires them,
+ * their scripts' frames go back to the pool.
+ * Must be called with the corresponding enemies' mutex locked.
+ * @param formations the formations' vector
+ * @param scripts the formations' scripts
+ */
+void remove_empty_formations(std::vector<Formation*> &formations, Script_scheduler &scripts) {
+    std::vector<Formation*>::iterator it = formations.begin();
+    while (it != formations.end()) {
+        if ((*it)->isDone()) {
+            enemies_index->remove(*it);
+            scripts.release(*it);
+            Epoch::retire(*it);
+            it = formations.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
 /**
  * Removes the bullets, which have reached their destination,
- * from the player_bullets.
- * Joins the threads connected with those bullets and removes
- * them from the player_bullet_threads_vector as well.
+ * from the bullets' vectors and indexes. The bullets past their
+ * last event are retired, to be freed when no thread can see them.
  *
  * Contains bullets_vector_mutex critical section
  */
 void remove_used_bullets() {
+    Trace::Scope scope("remove bullets");
     small_bullets_mutex.lock(); // Critical section - erasing data from the small bullets vectors
     if (small_bullets_vector.size() > 0) {
         std::vector<SmallBullet*>::iterator it = small_bullets_vector.begin();
         int j = 0;
         while (it != small_bullets_vector.end()) {
             if (small_bullets_vector[j]->isDone()) {
+                enemy_bullets_index->remove(small_bullets_vector[j]);
                 it = small_bullets_vector.erase(it);
             } else {
                 j++; it++;
@@ -324,6 +777,7 @@ void remove_used_bullets() {
         int j = 0;
         while (it != big_bullets_vector.end()) {
             if (big_bullets_vector[j]->isDone()) {
+                enemy_bullets_index->remove(big_bullets_vector[j]);
                 it = big_bullets_vector.erase(it);
             } else {
                 j++; it++;
@@ -338,6 +792,10 @@ void remove_used_bullets() {
         int j = 0;
         while (it != player_bullets_vector.end()) {
             if (player_bullets_vector[j]->isDone()) {
+                player_bullets_index->remove(player_bullets_vector[j]);
+                danger_mutex.lock();
+                danger_map->remove(player_bullets_vector[j]);
+                danger_mutex.unlock();
                 it = player_bullets_vector.erase(it);
             } else {
                 j++; it++;
@@ -345,123 +803,128 @@ void remove_used_bullets() {
         }
     }
     player_bullets_mutex.unlock(); // End of critical section
+
+    /// The exited bullets were done in the previous frame, so they have just left the vectors
+    for (Bullet* bullet : exited_bullets) {
+        Epoch::retire(bullet);
+    }
+    exited_bullets.clear();
 }
 /**
- * Prints the bullets shot by the player
+ * Prints the bullets inside the viewport
+ * @param dots true to composite them into the Braille layer instead
  */
-void draw_bullets() {
-    for (SmallBullet* bullet : small_bullets_vector) {
-        if (!bullet->isDone()) {
-            attron( A_BOLD );
-            if ( has_colors() ) {
-                attron( COLOR_PAIR(MODE_RED));
-            }
-            ncurses_mutex.lock();
-            bullet->drawActor();
-            ncurses_mutex.unlock();
-            if ( has_colors() ) {
-                attroff( COLOR_PAIR(MODE_RED));
+void draw_bullets(bool dots) {
+    Trace::Scope scope("draw bullets");
+    long now = current_tick();
+    draw_bullets_indexed(enemy_bullets_index, MODE_RED, now, dots);
+    draw_bullets_indexed(player_bullets_index, MODE_GREEN, now, dots);
+}
+/**
+ * Draws the bullets from the column index which are inside the viewport.
+ * Only the bullets in the viewport's columns have their rows computed.
+ * @param index the column index of the bullets to be drawn
+ * @param color_mode the color pair to be used
+ * @param now the current time in milliseconds
+ * @param dots true to composite them into the Braille layer instead
+ */
+void draw_bullets_indexed(Spatial_index* index, short color_mode, long now, bool dots) {
+    if (dots) {
+        index->forEachNear(*viewport, [now, color_mode](Game_actor* actor) {
+            Bullet* bullet = static_cast<Bullet*>(actor);
+            bullet->advance(now);
+            if (!bullet->isDone() && viewport->isVisible(bullet)) {
+                bullet->drawDots(*viewport, braille, now, color_mode);
             }
-            attroff( A_BOLD );
-        }
+        });
+        return;
     }
-    for (SmallBullet* bullet : player_bullets_vector) {
-        if (!bullet->isDone()) {
-            attron( A_BOLD );
-            if ( has_colors() ) {
-                attron( COLOR_PAIR(MODE_GREEN));
-            }
-            ncurses_mutex.lock();
-            bullet->drawActor();
-            ncurses_mutex.unlock();
-            if ( has_colors() ) {
-                attroff( COLOR_PAIR(MODE_GREEN));
-            }
-            attroff( A_BOLD );
-        }
+    attron( A_BOLD );
+    if ( has_colors() ) {
+        attron( COLOR_PAIR(color_mode));
     }
-    for (BigBullet* bullet : big_bullets_vector) {
-        if (!bullet->isDone()) {
-            attron( A_BOLD );
-            if ( has_colors() ) {
-                attron( COLOR_PAIR(MODE_RED));
-            }
+    index->forEachNear(*viewport, [now](Game_actor* actor) {
+        Bullet* bullet = static_cast<Bullet*>(actor);
+        bullet->advance(now);
+        if (!bullet->isDone() && viewport->isVisible(bullet)) {
             ncurses_mutex.lock();
-            bullet->drawActor();
+            bullet->drawActor(*viewport);
             ncurses_mutex.unlock();
-            if ( has_colors() ) {
-                attroff( COLOR_PAIR(MODE_RED));
-            }
-            attroff( A_BOLD );
         }
+    });
+    if ( has_colors() ) {
+        attroff( COLOR_PAIR(color_mode));
     }
+    attroff( A_BOLD );
 }
 /**
- * Shoot the bullet on a vertical course
- * @param bullet the bullet to be shot
- * @param dir the direction, "UP" or "DOWN"
- * @param speed the bullet's speed in rows per second
+ * Draws the actors from the index which are inside the viewport.
+ * The cost depends only on the number of the actors on the screen.
+ * @param index the index of the actors to be drawn
+ * @param color_mode the color pair to be used, 0 for the default one
  */
-void shoot_small_bullets() {
-    int milis_per_row = 1000/small_bullets_speed;
-    std::chrono::milliseconds t_row(milis_per_row);
-    while (!game_over) {
-        small_bullets_mutex.lock();
-        for (SmallBullet* bullet : small_bullets_vector) {
-            if (!bullet->isDone()) {
-                bullet->move(0, 1);
-            }
-        }
-        small_bullets_mutex.unlock();
-        player_bullets_mutex.lock();
-        for (SmallBullet* bullet : player_bullets_vector) {
-            if (!bullet->isDone()) {
-                bullet->move(0, -1);
-            }
-        }
-        player_bullets_mutex.unlock();
-        std::this_thread::sleep_for(t_row);
+void draw_indexed(Spatial_index* index, short color_mode) {
+    attron( A_BOLD );
+    if ( color_mode && has_colors() ) {
+        attron( COLOR_PAIR(color_mode));
+    }
+    index->forEachVisible(*viewport, [](Game_actor* actor) {
+        ncurses_mutex.lock();
+        actor->drawActor(*viewport);
+        ncurses_mutex.unlock();
+    });
+    if ( color_mode && has_colors() ) {
+        attroff( COLOR_PAIR(color_mode));
     }
+    attroff( A_BOLD );
 }
 /**
  * Creates bullets to be shot by specified player
- * and shoots them by launching threads for them.
+ * and launches them on their course.
  *
  * Contains bullets_vector_mutex critical section
  * @param player the player who shoots
  */
 void player_shoots(Game_actor &player) {
     // Create the bullet
-    SmallBullet* bullet = new SmallBullet( short(player.getPos_x() + player.getWidth()/2), short(player.getPos_y()), 0, getmaxx( stdscr ), 0,
+    SmallBullet* bullet = new SmallBullet( short(player.getPos_x() + player.getWidth()/2), short(player.getPos_y()), 0, world_maxx, 0,
                                            player.getPos_y());
-    bullet->move_direction = UP;
-    // Shoot the bullets
-    player_bullets_mutex.lock(); // Critical section - adding data to the small bullets vectors
-    player_bullets_vector.push_back(bullet);
-    player_bullets_mutex.unlock(); // End of critical section
+    long now = current_tick();
+    bullet->launch(now, small_bullets_speed, UP);
+    // Shoot the bullet at the end of the frame
+    Command_buffer::spawn(PLAYER_BULLETS, bullet);
+    Command_buffer::submit(now);
 }
 /**
- * Draws the enemies on the screen
- *
- * Contains a enemies_mutex critical section
+ * Draws the enemies inside the viewport
+ * @param coarse true to draw the formations in the upper half of the viewport,
+ *               far from the player, from their density grids
  */
-void draw_enemies() {
+void draw_enemies(bool coarse) {
+    Trace::Scope scope("draw enemies");
     big_enemies_mutex.lock();
-    for(Game_actor* enemy : big_slow_enemies_vector) {
-        ncurses_mutex.lock();
-        enemy->drawActor();
-        ncurses_mutex.unlock();
-    }
-    big_enemies_mutex.unlock();
-
     small_enemies_mutex.lock();
-    for (Game_actor* enemy : small_fast_enemies_vector) {
-        ncurses_mutex.lock();
-        enemy->drawActor();
-        ncurses_mutex.unlock();
+    if (coarse) {
+        int horizon = viewport->getOrigin_y() + viewport->getRows() / 2;
+        attron( A_BOLD );
+        enemies_index->forEachVisible(*viewport, [horizon](Game_actor* actor) {
+            /// The enemies' index holds formations only
+            Formation* formation = static_cast<Formation*>(actor);
+            ncurses_mutex.lock();
+            if (formation->getPos_y() + formation->getHeight() <= horizon) {
+                formation->drawCoarse(*viewport);
+            } else {
+                formation->drawActor(*viewport);
+            }
+            ncurses_mutex.unlock();
+        });
+        attroff( A_BOLD );
+    } else {
+        draw_indexed(enemies_index, 0);
     }
     small_enemies_mutex.unlock();
-};
+    big_enemies_mutex.unlock();
+}
 
 void draw_health(Player &player) {
     int hp = player.getHit_points();
@@ -482,91 +945,135 @@ void draw_health(Player &player) {
     }
     mvprintw(0,10+offset, "]");
 }
-/// Big enemies functions
+
 /**
- * Changes the coordinates of the big slow enemies.
- * They go from left to right, or right to left. When they reach the wall,
- * they go down one row. With 1% probbility they can change the route unexpextedly and
- * go down one row. When they reach the bottom of the screen, the game is over.
- */
-void move_big_slow_enemies() {
-    int milis_per_column = 1000/big_slow_enemy_speed;
-    std::chrono::milliseconds t_col(milis_per_column);
-    while(!game_over) {
-        for (Enemy_big_slow* enemy : big_slow_enemies_vector) {
-            if ( dice() > 99) {
-                enemy->move_direction = enemy->move_direction == RIGHT ? LEFT : RIGHT;
-                enemy->move(0, 1);
-                if (isHit(enemy,shield)) {
-                    enemy->move(0, -1);
-                }
-            }
-            if (enemy->move_direction == RIGHT) {
-                if (enemy->getPos_x() + enemy->getWidth() < enemy->getMax_x()) {
-                    enemy->move(1, 0);
-                    if (isHit(enemy,shield)) {
-                        enemy->move_direction = enemy->move_direction == RIGHT ? LEFT : RIGHT;
-                        enemy->move(-2, 0);
-                    }
-                } else {
-                    enemy->move(0, 1);
-                    enemy->move_direction = LEFT;
-                }
-                if (enemy->getPos_y() + enemy->getHeight() == enemy->getMax_y()) {
-                    game_over = true;
-                }
-                continue;
-            }
-            if (enemy->move_direction == LEFT) {
-                if (enemy->getPos_x() > enemy->getMin_x()) {
-                    enemy->move(-1, 0);
-                    if (isHit(enemy,shield)) {
-                        enemy->move_direction = enemy->move_direction == RIGHT ? LEFT : RIGHT;
-                        enemy->move(2, 0);
-                    }
-                } else {
-                    enemy->move(0, 1);
-                    enemy->move_direction = RIGHT;
-                }
-                if (enemy->getPos_y() + enemy->getHeight() == enemy->getMax_y()) {
-                    game_over = true;
-                }
-                continue;
+ * Prints a line of the HUD into its pad
+ * @param hud the HUD's pad
+ * @param line the line of the pad
+ * @param format the printf format of the line
+ * @return the width taken by the line
+ */
+int print_hud(WINDOW* hud, int line, const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    wmove(hud, line, 0);
+    vw_printw(hud, format, arguments);
+    va_end(arguments);
+    return getcury(hud) > line ? getmaxx(hud) : getcurx(hud);
+}
+/// Formations functions
+/**
+ * The game as seen by the scripts of one kind of enemies
+ */
+class Enemies_host : public Script_host {
+public:
+    /**
+     * @param _big true for the big slow enemies, false for the small fast ones
+     * @param _milis_per_column how long the formations take to move one column
+     */
+    Enemies_host(bool _big, int _milis_per_column) : big(_big), milis_per_column(_milis_per_column), now(0) {}
+
+    int dice() {
+        return ::dice();
+    }
+
+    Direction evade(const Formation &formation) {
+        danger_mutex.lock();
+        Direction way_out = danger_map->evade(formation, now, milis_per_column);
+        danger_mutex.unlock();
+        return way_out;
+    }
+
+    void march(Formation &formation, bool turn) {
+        if (formation.march(turn, *shields)) {
+            game_over = true;
+        }
+    }
+
+    void descend(Formation &formation) {
+        if (formation.descend(*shields)) {
+            game_over = true;
+        }
+    }
+
+    /**
+     * Shoots from at most script_volley members spread over the formation,
+     * the bullets are spawned at the end of the frame
+     */
+    void fire(const Formation &formation) {
+        const std::vector<Game_actor*> &members = formation.getMembers();
+        unsigned long stride = std::max(members.size() / script_volley, 1UL);
+        for (unsigned long i = 0; i < members.size(); i += stride) {
+            if (members[i]->isDone()) continue;
+            if (big) {
+                big_slow_enemy_shoots(*static_cast<Enemy_big_slow*>(members[i]));
+            } else {
+                small_fast_enemy_shoots(*static_cast<Enemy_small_fast*>(members[i]));
             }
         }
-        std::this_thread::sleep_for(t_col);
     }
-}
+
+    /**
+     * @param _now the time of the tick, in milliseconds since the start of the game
+     */
+    void setNow(long _now) { now = _now; }
+
+private:
+    bool big;
+    int milis_per_column;
+    long now;
+};
+
 /**
- *
+ * Runs the scripts of all the formations on a single thread. The small enemies' scripts
+ * are resumed every tick, the big ones' every other tick, as they are half as fast.
+ * The bullets shot by the scripts are submitted once per tick.
  */
-void create_big_slow_enemies_bullets() {
-    std::chrono::milliseconds t_bullet(t_big_enemies_bullets);
-    while (!game_over) {
-        for (Enemy_big_slow *enemy : big_slow_enemies_vector) {
-            big_slow_enemy_shoots(*enemy);
+void run_enemy_scripts() {
+    int milis_per_tick = 1000/small_fast_enemy_speed;
+    long ticks_per_big_step = small_fast_enemy_speed/big_slow_enemy_speed;
+    Enemies_host big_host(true, 1000/big_slow_enemy_speed);
+    Enemies_host small_host(false, milis_per_tick);
+    std::chrono::milliseconds t_tick(milis_per_tick);
+    Trace::nameThread("enemy scripts");
+    for (long tick = 0; !game_over; tick++) {
+        int64_t tick_start = Trace::clock();
+        long now = current_tick();
+        if (tick % ticks_per_big_step == 0) {
+            big_host.setNow(now);
+            big_enemies_mutex.lock();
+            big_scripts.resume(big_formations_vector, big_host, enemies_index);
+            big_enemies_mutex.unlock();
         }
-        std::this_thread::sleep_for(t_bullet);
+        small_host.setNow(now);
+        small_enemies_mutex.lock();
+        small_scripts.resume(small_formations_vector, small_host, enemies_index);
+        small_enemies_mutex.unlock();
+        Command_buffer::submit(now);
+        Trace::slice("scripts", "game", tick_start);
+        std::this_thread::sleep_for(t_tick);
     }
 }
+
+/// Big enemies functions
 /**
- * Shoot the bullet on a vertical course
- * @param bullet the bullet to be shot
- * @param dir the direction, "UP" or "DOWN"
- * @param speed the bullet's speed in rows per second
+ *
  */
-void shoot_big_bullets() {
-    int milis_per_row = 1000/big_bullets_speed;
-    std::chrono::milliseconds t_row(milis_per_row);
+void create_big_slow_enemies_bullets() {
+    std::chrono::milliseconds t_bullet(t_big_enemies_bullets);
+    Trace::nameThread("big enemies shooting");
     while (!game_over) {
-        big_bullets_mutex.lock();
-        for (BigBullet* bullet : big_bullets_vector) {
-            if (!bullet->isDone()) {
-                bullet->move(0, bullet->move_direction == DOWN ? short(1) : short(-1));
+        {
+            Trace::Scope scope("volley");
+            Epoch::Guard guard;
+            const std::vector<Enemy_big_slow*> &enemies = big_slow_enemies_published.read();
+            Command_buffer::reserve(enemies.size());
+            for (Enemy_big_slow *enemy : enemies) {
+                big_slow_enemy_shoots(*enemy);
             }
         }
-        big_bullets_mutex.unlock();
-        std::this_thread::sleep_for(t_row);
+        Command_buffer::submit(current_tick());
+        std::this_thread::sleep_for(t_bullet);
     }
 }
 /**
@@ -575,26 +1082,28 @@ void shoot_big_bullets() {
  */
 void big_slow_enemy_shoots(Enemy_big_slow &enemy) {
     // Create the bullets
-    BigBullet* bullet = new BigBullet( short(enemy.getPos_x() + enemy.getWidth()/2 - 1), short(enemy.getPos_y()+1), 0, getmaxx( stdscr ), 0,
-                                       getmaxy( stdscr ) + 3);
-    bullet->move_direction = DOWN;
-    // Shoot the bullets
-    big_bullets_mutex.lock(); // Critical section - adding data to the bullets vectors
-    big_bullets_vector.push_back(bullet);
-    big_bullets_mutex.unlock(); // End of critical section
+    BigBullet* bullet = Enemy_rules::bigBullet(enemy, world_maxx, world_maxy);
+    bullet->launch(current_tick(), big_bullets_speed, DOWN);
+    // Shoot the bullet at the end of the frame
+    Command_buffer::spawn(BIG_BULLETS, bullet);
 }
 /**
  *
  */
 void create_big_enemy() {
-    int stdscr_maxx = getmaxx( stdscr );
-    int stdscr_maxy = getmaxy( stdscr );
+    Trace::nameThread("big enemies creation");
     while (!game_over) {
-        Enemy_big_slow* enemy_big_slow = new Enemy_big_slow( stdscr_maxx/dice(), 0, 0, stdscr_maxx, 0, stdscr_maxy );
-        enemy_big_slow->move_direction = RIGHT;
-        big_enemies_mutex.lock();
-        big_slow_enemies_vector.push_back(enemy_big_slow);
-        big_enemies_mutex.unlock();
+        int64_t wave_start = Trace::clock();
+        Formation* formation = Enemy_rules::lineUp<Enemy_big_slow>(world_maxx/dice(), big_formation_columns, RIGHT,
+                                                                   world_maxx, world_maxy);
+        /// The whole wave is spawned at the end of the frame, in a single batch
+        Command_buffer::reserve(big_formation_columns + 1);
+        for (Game_actor* enemy_big_slow : formation->getMembers()) {
+            Command_buffer::spawn(BIG_ENEMIES, enemy_big_slow);
+        }
+        Command_buffer::spawn(BIG_FORMATIONS, formation);
+        Command_buffer::submit(current_tick());
+        Trace::slice("wave", "game", wave_start);
         std::this_thread::sleep_for(t_between_big_enemies);
     }
 }
@@ -606,23 +1115,36 @@ void create_big_enemy() {
  */
 void small_fast_enemy_shoots(Enemy_small_fast &enemy) {
     // Create the bullets
-    SmallBullet* bullet = new SmallBullet( short(enemy.getPos_x() + enemy.getWidth()/2 ), short(enemy.getPos_y()), 0, getmaxx( stdscr ), 0,
-                                           getmaxy( stdscr ));
-    bullet->move_direction = DOWN;
-    // Shoot the bullets
-    small_bullets_mutex.lock(); // Critical section - adding data to the bullets vectors
-    small_bullets_vector.push_back(bullet);
-    small_bullets_mutex.unlock(); // End of critical section
+    SmallBullet* bullet = Enemy_rules::smallBullet(enemy, world_maxx, world_maxy);
+    bullet->launch(current_tick(), small_bullets_speed, DOWN);
+    // Shoot the bullet at the end of the frame
+    Command_buffer::spawn(SMALL_BULLETS, bullet);
 }
 /**
  *
  */
 void create_small_fast_enemies_bullets() {
     std::chrono::milliseconds t_bullet(t_small_enemies_bullets);
+    Trace::nameThread("small enemies shooting");
     while (!game_over) {
-        for (Enemy_small_fast *enemy : small_fast_enemies_vector) {
-            small_fast_enemy_shoots(*enemy);
+        {
+            Trace::Scope scope("volley");
+            Epoch::Guard guard;
+            const std::vector<Enemy_small_fast*> &enemies = small_fast_enemies_published.read();
+            if (swarm_size > 0 && enemies.size() > swarm_volley) {
+                /// Only a handful of the swarm shoots at once
+                Command_buffer::reserve(swarm_volley);
+                for (unsigned long i = 0; i < swarm_volley; i++) {
+                    small_fast_enemy_shoots(*enemies[random() % enemies.size()]);
+                }
+            } else {
+                Command_buffer::reserve(enemies.size());
+                for (Enemy_small_fast *enemy : enemies) {
+                    small_fast_enemy_shoots(*enemy);
+                }
+            }
         }
+        Command_buffer::submit(current_tick());
         std::this_thread::sleep_for(t_bullet);
     }
 }
@@ -630,76 +1152,252 @@ void create_small_fast_enemies_bullets() {
  *
  */
 void create_small_enemy() {
-    int stdscr_maxx = getmaxx( stdscr );
-    int stdscr_maxy = getmaxy( stdscr );
+    Trace::nameThread("small enemies creation");
     while (!game_over) {
-        Enemy_small_fast* enemy_small_fast = new Enemy_small_fast( stdscr_maxx/dice(), 0, 0, stdscr_maxx, 0, stdscr_maxy );
-        enemy_small_fast->move_direction = LEFT;
-        small_enemies_mutex.lock();
-        small_fast_enemies_vector.push_back(enemy_small_fast);
-        small_enemies_mutex.unlock();
+        if (swarm_size > 0) {
+            create_swarm_wave();
+            std::this_thread::sleep_for(t_between_small_enemies);
+            continue;
+        }
+        int64_t wave_start = Trace::clock();
+        Formation* formation = Enemy_rules::lineUp<Enemy_small_fast>(world_maxx/dice(), small_formation_columns, LEFT,
+                                                                     world_maxx, world_maxy);
+        /// The whole wave is spawned at the end of the frame, in a single batch
+        Command_buffer::reserve(small_formation_columns + 1);
+        for (Game_actor* enemy_small_fast : formation->getMembers()) {
+            Command_buffer::spawn(SMALL_ENEMIES, enemy_small_fast);
+        }
+        Command_buffer::spawn(SMALL_FORMATIONS, formation);
+        Command_buffer::submit(current_tick());
+        Trace::slice("wave", "game", wave_start);
         std::this_thread::sleep_for(t_between_small_enemies);
     }
 }
 /**
- * Changes the coordinates of the big slow enemies.
- * They go from left to right, or right to left. When they reach the wall,
- * they go down one row. With 1% probbility they can change the route unexpextedly and
- * go down one row. When they reach the bottom of the screen, the game is over.
+ * Spawns a wave of the swarm: one formation of small enemies scattered over a block a third
+ * of the world wide, many of them sharing a cell. The waves stop coming while the swarm is complete.
  */
-void move_small_fast_enemies() {
-    int milis_per_column = 1000/small_fast_enemy_speed;
-    std::chrono::milliseconds t_col(milis_per_column);
-    while(!game_over) {
-        for (Enemy_small_fast* enemy : small_fast_enemies_vector) {
-            if ( dice() > 95) {
-                enemy->move_direction = enemy->move_direction == RIGHT ? LEFT : RIGHT;
-                enemy->move(0, 1);
-                if (isHit(enemy,shield)) {
-                    enemy->move(0, -1);
-                }
-            }
-            if (enemy->move_direction == RIGHT) {
-                if (enemy->getPos_x() + enemy->getWidth() < enemy->getMax_x()) {
-                    enemy->move(1, 0);
-                    if (isHit(enemy,shield)) {
-                        enemy->move_direction = enemy->move_direction == RIGHT ? LEFT : RIGHT;
-                        enemy->move(-2, 0);
-                    }
-                } else {
-                    enemy->move(0, 1);
-                    enemy->move_direction = LEFT;
-                }
-                if (enemy->getPos_y() + enemy->getHeight() == enemy->getMax_y()) {
-                    game_over = true;
-                }
-                continue;
-            }
-            if (enemy->move_direction == LEFT) {
-                if (enemy->getPos_x() > enemy->getMin_x()) {
-                    enemy->move(-1, 0);
-                    if (isHit(enemy,shield)) {
-                        enemy->move_direction = enemy->move_direction == RIGHT ? LEFT : RIGHT;
-                        enemy->move(2, 0);
-                    }
-                } else {
-                    enemy->move(0, 1);
-                    enemy->move_direction = RIGHT;
-                }
-                if (enemy->getPos_y() + enemy->getHeight() == enemy->getMax_y()) {
-                    game_over = true;
-                }
-                continue;
-            }
+void create_swarm_wave() {
+    Trace::Scope scope("swarm wave");
+    unsigned long alive;
+    {
+        Epoch::Guard guard;
+        alive = small_fast_enemies_published.read().size();
+    }
+    if (alive >= swarm_size) return;
+    unsigned long members = std::min(std::max(swarm_size / swarm_waves, 1UL), swarm_size - alive);
+    int columns = world_maxx / 3;
+    Formation* formation = new Formation( 0, 0, 0, world_maxx, 0, world_maxy );
+    formation->move_direction = LEFT;
+    int left = (int) (random() % (world_maxx - columns));
+    /// The whole wave is spawned at the end of the frame, in a single batch. The first member
+    /// takes the corner of the block, so the others join without moving the members before them.
+    Command_buffer::reserve(members + 1);
+    for (unsigned long i = 0; i < members; i++) {
+        int x = i == 0 ? left : left + (int) (random() % (columns - 5));
+        int y = i == 0 ? 0 : (int) (random() % swarm_rows);
+        Enemy_small_fast* enemy_small_fast = new Enemy_small_fast( x, y, 0, world_maxx, 0, world_maxy );
+        formation->addMember(enemy_small_fast);
+        Command_buffer::spawn(SMALL_ENEMIES, enemy_small_fast);
+    }
+    Command_buffer::spawn(SMALL_FORMATIONS, formation);
+    Command_buffer::submit(current_tick());
+}
+/// Automated players
+/**
+ * Fills the observation with the part of the world inside the viewport.
+ * The bullets' rows are computed from their trajectories without moving them.
+ * @param observation the caller's observation, as big as the terminal
+ * @param player the player
+ */
+void observe_game(Observation &observation, Player &player) {
+    Trace::Scope scope("observe");
+    /// The rendering thread moves and resizes the viewport, so the observation works on a copy
+    player_mutex.lock();
+    Viewport view = *viewport;
+    player_mutex.unlock();
+    observation.clear(view.getOrigin_x(), view.getOrigin_y());
+    for (Shield* shield : shields->getShields()) {
+        if (view.isVisible(shield)) {
+            observation.stampShield(shield);
         }
-        std::this_thread::sleep_for(t_col);
     }
+    big_enemies_mutex.lock();
+    for (Enemy_big_slow* enemy : big_slow_enemies_vector) {
+        observation.stamp(enemy, Observation::BIG_ENEMY);
+    }
+    big_enemies_mutex.unlock();
+    small_enemies_mutex.lock();
+    for (Enemy_small_fast* enemy : small_fast_enemies_vector) {
+        observation.stamp(enemy, Observation::SMALL_ENEMY);
+    }
+    small_enemies_mutex.unlock();
+    long now = current_tick();
+    enemy_bullets_index->forEachNear(view, [&observation, now](Game_actor* actor) {
+        Bullet* bullet = static_cast<Bullet*>(actor);
+        observation.stamp(bullet->getPos_x(), bullet->rowAt(now), bullet->getWidth(), bullet->getHeight(),
+                          Observation::ENEMY_BULLET);
+    });
+    player_bullets_index->forEachNear(view, [&observation, now](Game_actor* actor) {
+        Bullet* bullet = static_cast<Bullet*>(actor);
+        observation.stamp(bullet->getPos_x(), bullet->rowAt(now), bullet->getWidth(), bullet->getHeight(),
+                          Observation::PLAYER_BULLET);
+    });
+    player_mutex.lock();
+    observation.stamp(&player, Observation::PLAYER);
+    observation.setHit_points(player.getHit_points());
+    player_mutex.unlock();
+}
+/**
+ * Does what the policy has decided
+ * @param player the player
+ * @param action the action, ACTION_QUIT is handled by the caller
+ */
+void apply_action(Player &player, Action action) {
+    if ( action == ACTION_FIRE ) {
+        player_shoots(player);
+    }
+
+    if ( action == ACTION_LEFT ) {
+        /// Move player left
+        player_mutex.lock();
+        player.move(-1, 0);
+        player_mutex.unlock();
+    }
+
+    if ( action == ACTION_RIGHT ) {
+        /// Move player right
+        player_mutex.lock();
+        player.move(1, 0);
+        player_mutex.unlock();
+    }
+}
+/**
+ * Plays the given number of headless games with the aiming bot and prints the results.
+ * All the games are stepped together, frame by frame.
+ * @param games the number of games
+ * @param frames the maximum number of frames of a game
+ * @return the exit code
+ */
+int run_headless(int games, int frames) {
+    Vector_env env(games, 120, 40, 1);
+    std::vector<Aim_policy> policies((unsigned long) games);
+    std::vector<Action> actions((unsigned long) games, ACTION_NONE);
+    for (int frame = 0; frame < frames; frame++) {
+        bool all_over = true;
+        for (int i = 0; i < games; i++) {
+            actions[i] = policies[i].act(env.getObservation(i));
+            all_over = all_over && env.getWorld(i).isOver();
+        }
+        if (all_over) break;
+        env.step(actions.data());
+    }
+    Score_log log(score_log_path);
+    for (int i = 0; i < games; i++) {
+        const World &world = env.getWorld(i);
+        log.append(world.getPoints(), world.getBig_ships_destroyed(), world.getSmall_ships_destroyed());
+        std::cout << "game " << i
+                  << " time " << world.getTime() / 1000 << "s"
+                  << " health " << world.getHit_points()
+                  << " bombers " << world.getBig_ships_destroyed()
+                  << " fighters " << world.getSmall_ships_destroyed()
+                  << " score " << world.getPoints() << std::endl;
+    }
+    return 0;
+}
+
+/// Co-op game
+/**
+ * Hosts the co-op game and keeps its result in the score log
+ * @param path the path of the socket
+ * @param players the number of players
+ * @param seed the seed of the world
+ */
+int run_server(const char* path, int players, unsigned int seed) {
+    if (players < 1 || players > Net_message::MAX_PLAYERS) {
+        std::cerr << "From 1 to " << Net_message::MAX_PLAYERS << " players can play together" << std::endl;
+        return 1;
+    }
+    Coop_server server(path, players, seed, 120, 40);
+    int code = server.run();
+    const World &world = server.getWorld();
+    if (code == 0) {
+        Score_log log(score_log_path);
+        log.append(world.getPoints(), world.getBig_ships_destroyed(), world.getSmall_ships_destroyed());
+    }
+    return code;
+}
+
+/**
+ * Joins the co-op game, ncurses must be initialized
+ * @param path the path of the server's socket
+ * @param bot true if the aiming bot plays instead of the keyboard
+ */
+int run_client(const char* path, bool bot) {
+    Policy* policy = bot ? (Policy*) new Aim_policy() : (Policy*) new Keyboard_policy();
+    Coop_client client(path, policy, bot);
+    int code = client.run();
+    endwin();
+    if (code != 0) {
+        std::cerr << "Can't join the game at " << path << std::endl;
+    } else {
+        client.printStats(std::cout);
+    }
+    delete policy;
+    return code;
 }
 ///////////////////////////////////////////////////////////
 
-int main() {
+/**
+ * Takes an option with its value out of the arguments
+ * @param argc the number of the arguments, less by two if the option is found
+ * @param argv the arguments
+ * @param name the option
+ * @return the option's value, or nullptr when there is no such option
+ */
+const char* take_option(int &argc, char** argv, const char* name) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == name) {
+            const char* value = argv[i + 1];
+            for (int j = i; j + 2 < argc; j++) {
+                argv[j] = argv[j + 2];
+            }
+            argc -= 2;
+            return value;
+        }
+    }
+    return nullptr;
+}
 
-    /// Initialize ncurses
+int main(int argc, char** argv) {
+    /// "--record <file>", "--trace <file>" and "--swarm <enemies>" may follow any of the modes showing the game
+    const char* record_path = take_option(argc, argv, "--record");
+    const char* trace_path = take_option(argc, argv, "--trace");
+    if (trace_path != nullptr) {
+        Trace::open(trace_path);
+    }
+    Trace::nameThread("input");
+    const char* swarm = take_option(argc, argv, "--swarm");
+    if (swarm != nullptr) {
+        swarm_size = (unsigned long) std::atol(swarm);
+    }
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--headless") {
+        return run_headless(argc > 2 ? std::atoi(argv[2]) : 16, argc > 3 ? std::atoi(argv[3]) : 7500);
+    }
+    if (mode == "--serve" && argc > 2) {
+        return run_server(argv[2], argc > 3 ? std::atoi(argv[3]) : 2, argc > 4 ? (unsigned int) std::atoi(argv[4]) : 1);
+    }
+    if (mode == "--proxy" && argc > 3) {
+        Delay_proxy proxy(argv[2], argv[3], argc > 4 ? std::atoi(argv[4]) : 50, argc > 5 ? std::atoi(argv[5]) : 100);
+        return proxy.run();
+    }
+    bool bot = mode == "--bot";
+
+    /// Initialize ncurses, taking the terminal's character set from the environment for the Braille mode
+#ifdef SPACE_INVADERS_BRAILLE
+    std::setlocale(LC_CTYPE, "");
+#endif
     initscr();
     keypad( stdscr, TRUE );
     curs_set( FALSE );
@@ -711,11 +1409,17 @@ int main() {
         init_pair( MODE_GREEN, COLOR_GREEN, COLOR_BLACK );
         init_pair( MODE_RED, COLOR_RED, COLOR_BLACK );
     }
+    if (mode == "--join" && argc > 2) {
+        return run_client(argv[2], argc > 3 && std::string(argv[3]) == "--bot");
+    }
+
     /// Create player and shield
     int stdscr_maxx = getmaxx( stdscr );
     int stdscr_maxy = getmaxy( stdscr );
+    score_log = new Score_log(score_log_path);
+    std::vector<Score_log::Score> best = score_log->top();
 
-    while (true) {
+    while (!bot) {
         if (has_colors()) attron( COLOR_PAIR(MODE_RED));
         attron(A_BOLD);
         mvprintw(stdscr_maxy/2-4, stdscr_maxx/2 -7, "SPACE INVADERS");
@@ -727,7 +1431,20 @@ int main() {
         mvprintw(stdscr_maxy/2+2, stdscr_maxx/2-14, "or one of the invader's ships reaches the Earth!");
         mvprintw(stdscr_maxy/2+3, stdscr_maxx/2 -14, "Press 'q to quit, any other key to start!");
         mvprintw(stdscr_maxy/2+4, stdscr_maxx/2-14, "Good luck! ;)");
+        if (!best.empty()) {
+            mvprintw(stdscr_maxy/2+6, stdscr_maxx/2 -14, "HIGH SCORES (%u games played)", score_log->size());
+        }
+        for (int i = 0; i < (int) best.size() && i < 5; i++) {
+            mvprintw(stdscr_maxy/2+7+i, stdscr_maxx/2 -14, "%d. %6d  bombers %d, fighters %d", i + 1,
+                     best[i].points, best[i].big_ships_destroyed, best[i].small_ships_destroyed);
+        }
         int c = getch();
+        if (c == KEY_RESIZE) {
+            stdscr_maxx = getmaxx( stdscr );
+            stdscr_maxy = getmaxy( stdscr );
+            clear();
+            continue;
+        }
         if(c != ERR) {
             if (c == 'q') {
                 clear();
@@ -738,38 +1455,88 @@ int main() {
         }
     }
 
-    Player* player = new Player(stdscr_maxx/2 - 3, stdscr_maxy - 1, 0, stdscr_maxx, 0, stdscr_maxy);
-    shield = new Shield(stdscr_maxx/2 - 10, stdscr_maxy - 7, stdscr_maxx, 0, stdscr_maxy, 0);
+    /// Create the world, the camera and the indexes
+    world_maxx = stdscr_maxx * world_columns_factor;
+    world_maxy = stdscr_maxy * world_rows_factor;
+    viewport = new Viewport(stdscr_maxx, stdscr_maxy, world_maxx, world_maxy);
+    enemies_index = new Spatial_index(world_maxx, world_maxy);
+    /// Bullets fly only vertically, so they are kept in column buckets as high as the world
+    enemy_bullets_index = new Spatial_index(world_maxx, world_maxy, Spatial_index::BUCKET_COLUMNS, world_maxy + 4);
+    player_bullets_index = new Spatial_index(world_maxx, world_maxy, Spatial_index::BUCKET_COLUMNS, world_maxy + 4);
+
+    Player* player = new Player(world_maxx/2 - 3, world_maxy - 1, 0, world_maxx, 0, world_maxy);
+    player_row = player->getPos_y();
+    shields = new Shield_wall(shields_count * world_columns_factor, world_maxx, world_maxy);
+    danger_map = new Danger_map(world_maxx);
+    narrowphase = new Narrowphase(std::thread::hardware_concurrency());
+    output = new Output_pacer(STDOUT_FILENO, frame_durtion);
+    if (record_path != nullptr) {
+        recorder = new Cast_recorder(record_path, stdscr_maxx, stdscr_maxy);
+    }
     /// Launch view refresh thread
     std::thread refresh_thread( refresh_view, std::ref(*player));
 
-    while (true) {
-        int key = getch();
-        if ( key == 'q') {
-            exit_condition = true;
-            break;
-        }
-
-        if ( key == SPACE ) {
-            player_shoots(*player);
-        }
+    /// The observation is only written, so it is allocated once for the whole game
+    Policy* policy = bot ? (Policy*) new Aim_policy() : (Policy*) new Keyboard_policy();
+    std::vector<unsigned char> observed_cells((unsigned long) (stdscr_maxx * stdscr_maxy));
+    int observed_hit_points = 0;
+    Observation observation(observed_cells.data(), &observed_hit_points, stdscr_maxx, stdscr_maxy);
+    if (bot) {
+        /// The bot acts once per frame, 'q' still quits
+        timeout( int(frame_durtion.count()) );
+    }
 
-        if ( key == 'a') {
-            /// Move player left
+    while (true) {
+        if (bot) {
+            int key = getch();
+            if (key == 'q' || exit_condition) {
+                exit_condition = true;
+                break;
+            }
+            if (key == 't') {
+                Trace::toggle();
+            }
+            if (key == 'm') {
+                Memory_stats::toggleHud();
+            }
+            if (key == 'b') {
+                Braille_layer::toggle();
+            }
+            /// After a resize the observation follows the size of the viewport
             player_mutex.lock();
-            player->move(-1, 0);
+            int columns = viewport->getColumns();
+            int rows = viewport->getRows();
             player_mutex.unlock();
+            if (columns != observation.getColumns() || rows != observation.getRows()) {
+                observed_cells.resize((unsigned long) (columns * rows));
+                observation = Observation(observed_cells.data(), &observed_hit_points, columns, rows);
+            }
+            observe_game(observation, *player);
         }
-
-        if ( key == 'd') {
-            /// Move player right
-            player_mutex.lock();
-            player->move(1, 0);
-            player_mutex.unlock();
+        Action action = policy->act(observation);
+        if ( action == ACTION_QUIT ) {
+            exit_condition = true;
+            break;
         }
-
+        apply_action(*player, action);
     }
+    delete policy;
     refresh_thread.join();
+    delete narrowphase;
     endwin();
+    output->printStats(std::cout);
+    delete output;
+    if (recorder != nullptr) {
+        recorder->stop();
+        recorder->printStats(std::cout);
+        delete recorder;
+    }
+    governor.printLog(std::cout);
+    Trace::write(std::cout);
+    sample_vectors();
+    Memory_stats::report(std::cout);
+#ifdef SPACE_INVADERS_LOCK_STATS
+    Game_mutex::report(std::cout, 5);
+#endif
     return 0;
 }
\ No newline at end of file